@@ -0,0 +1,91 @@
+#include "batchparser.h"
+
+BatchParser::BatchParser(HWParser::Options options_):
+    options(options_) {}
+
+SourceCache::ResultPtr BatchParser::parseFile(const QString &path)
+{
+    const std::string filePath = TranslationUnitParser::canonicalPath(path.toStdString());
+    cache.invalidate(filePath);
+    TranslationUnitParser parser(cache, options);
+    SourceCache::ResultPtr result = parser.parseFile(filePath);
+    //contents aren't needed after parse, keep only results
+    cache.invalidate(filePath);
+    fileResults[filePath] = result;
+    return result;
+}
+
+void BatchParser::removeFile(const QString &path)
+{
+    const std::string filePath = TranslationUnitParser::canonicalPath(path.toStdString());
+    cache.invalidate(filePath);
+    fileResults.erase(filePath);
+}
+
+const std::map<std::string, SourceCache::ResultPtr> &BatchParser::results() const
+{
+    return fileResults;
+}
+
+QStringList BatchParser::sourceFiles(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.isDir()) {
+        return {info.absoluteFilePath()};
+    }
+    QStringList files;
+    QDirIterator iter(info.absoluteFilePath(), QDir::Files, QDirIterator::Subdirectories);
+    while (iter.hasNext()) {
+        QString file = iter.next();
+        if (isSourceFile(file)) {
+            files.append(file);
+        }
+    }
+    return files;
+}
+
+bool BatchParser::isSourceFile(const QString &path)
+{
+    return sourceSuffixes.contains(QFileInfo(path).suffix().toLower());
+}
+
+QString BatchParser::formatTable(const ParseResult &result)
+{
+    QString output = QString::fromStdString(result.output);
+    QTextStream stream(&output);
+    bool rowComma = false;
+    stream << "{\n";
+    for (auto &row : result.table) {
+        if (rowComma) {
+            stream << ",\n";
+        }
+        rowComma = true;
+        bool cellComma = false;
+        stream << "  {\n";
+        for (auto &cell : row) {
+            if (cellComma) {
+                stream << ",\n";
+            }
+            cellComma = true;
+            stream << "    \"" << cell << "\"";
+        }
+        stream << "\n  }";
+    }
+    stream << "};\n";
+    return output;
+}
+
+QString BatchParser::formatFile(const FileParseResult &file)
+{
+    QString output;
+    QTextStream stream(&output);
+    stream << "//" << QString::fromStdString(file.path) << '\n';
+    if (!file.loaded) {
+        stream << "//can't read file\n";
+    }
+    for (auto &table : file.tables) {
+        stream << "//" << QString::fromStdString(table.identifier) << '\n'
+               << formatTable(table);
+    }
+    return output;
+}
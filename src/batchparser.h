@@ -0,0 +1,38 @@
+#ifndef BATCHPARSER_H
+#define BATCHPARSER_H
+
+#include "translationunit.h"
+
+#include <QtCore>
+
+#include <map>
+
+//Keeps last parse result of every file, so only changed files
+//have to be parsed again
+class BatchParser
+{
+public:
+    explicit BatchParser(HWParser::Options options_);
+    //Api
+    //drops cached result of file and parses it again
+    SourceCache::ResultPtr parseFile(const QString &path);
+    void removeFile(const QString &path);
+    const std::map<std::string, SourceCache::ResultPtr> &results() const;
+
+    static QStringList sourceFiles(const QString &path);
+    static bool isSourceFile(const QString &path);
+    static QString formatTable(const ParseResult &result);
+    static QString formatFile(const FileParseResult &file);
+
+protected:
+    //Static data
+    inline static const QStringList sourceSuffixes {
+        {"c"}, {"cc"}, {"cpp"}, {"cxx"}, {"h"}, {"hh"}, {"hpp"}, {"hxx"}, {"inc"}
+    };
+    //Data
+    SourceCache cache;
+    HWParser::Options options;
+    std::map<std::string, SourceCache::ResultPtr> fileResults;
+};
+
+#endif // BATCHPARSER_H
@@ -0,0 +1,60 @@
+#include "cli.h"
+
+#include "batchparser.h"
+#include "extractionwatcher.h"
+#include "parsedaemon.h"
+
+#include <QtCore>
+
+int runCommandLine(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser args;
+    args.setApplicationDescription("Extracts char* tables from C/C++ sources.");
+    args.addHelpOption();
+    args.addPositionalArgument("paths", "Source files or directories to extract tables from.");
+    QCommandLineOption watchOption({"w", "watch"},
+                                   "Keep running and extract files again when they change.");
+    QCommandLineOption outputOption({"o", "output-dir"},
+                                    "Write <file>.table outputs to directory instead of stdout.",
+                                    "dir");
+    QCommandLineOption debounceOption("debounce",
+                                      "Wait for more changes before extracting (default 20).",
+                                      "ms", "20");
+    QCommandLineOption statsOption("stats",
+                                   "Print memory held by tables and allocations of every parse.");
+    QCommandLineOption daemonOption("daemon",
+                                    "Serve parse requests on Unix domain socket instead.",
+                                    "socket");
+    QCommandLineOption threadsOption("threads",
+                                     "Worker threads of daemon (default is number of cores).",
+                                     "n", QString::number(QThread::idealThreadCount()));
+    args.addOptions({watchOption, outputOption, debounceOption, statsOption,
+                     daemonOption, threadsOption});
+    args.process(app);
+
+    if (args.isSet(daemonOption)) {
+        ParseDaemon daemon(args.value(daemonOption).toStdString(),
+                           args.value(threadsOption).toUInt());
+        if (!daemon.listen()) {
+            qCritical().noquote() << QString::fromStdString(daemon.errorString());
+            return 1;
+        }
+        daemon.run();
+        return 0;
+    }
+
+    const QStringList paths = args.positionalArguments();
+    if (paths.isEmpty()) {
+        args.showHelp(1);
+    }
+
+    BatchParser parser(HWParser::Options{});
+    ExtractionWatcher extraction(parser, paths);
+    extraction.setOutputDir(args.value(outputOption));
+    extraction.setDebounce(args.value(debounceOption).toInt());
+    extraction.setStatsEnabled(args.isSet(statsOption));
+    const bool watch = args.isSet(watchOption);
+    extraction.start(watch);
+    return watch ? app.exec() : 0;
+}
@@ -0,0 +1,7 @@
+#ifndef CLI_H
+#define CLI_H
+
+//Headless mode, used when program is started with arguments
+int runCommandLine(int argc, char *argv[]);
+
+#endif // CLI_H
@@ -0,0 +1,299 @@
+#ifndef CONSTEXPR_PARSER_HPP
+#define CONSTEXPR_PARSER_HPP
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+
+//Compile-time variant of HWParser grammar for tables embedded in binary:
+//    constexpr auto table = constexpr_parser::parse<Rows, Columns>(R"(...)");
+//Rows and Columns are capacities, literal may be smaller.
+//Syntax errors and overflows fail constant evaluation, so they are
+//reported as compile errors which name the failed expectation.
+namespace constexpr_parser {
+    using std::size_t;
+
+    struct CellSpan {
+        size_t begin = 0;
+        size_t size = 0;
+    };
+
+    //Decoded cells are stored in one char buffer, no larger than source
+    template <size_t Rows, size_t Columns, size_t Capacity>
+    struct StaticTable {
+        std::array<char, Capacity> storage {};
+        std::array<std::array<CellSpan, Columns>, Rows> cells {};
+        std::array<size_t, Rows> rowSizes {};
+        size_t rows = 0;
+        CellSpan identifierSpan;
+        //1 for char*, 2 for char**, 3 for char***
+        int pointerDepth = 0;
+        //0 if dimension is omitted or not declared
+        size_t declaredRows = 0;
+        size_t declaredColumns = 0;
+
+        constexpr std::string_view cell(size_t row, size_t column) const {
+            return view(cells[row][column]);
+        }
+        constexpr size_t columns(size_t row) const {
+            return rowSizes[row];
+        }
+        constexpr std::string_view identifier() const {
+            return view(identifierSpan);
+        }
+        constexpr std::string_view view(CellSpan span) const {
+            return {storage.data() + span.begin, span.size};
+        }
+    };
+
+    //throw is not a constant expression, so it stops compilation
+    constexpr void expect(bool condition, const char *message) {
+        if (!condition) {
+            throw std::invalid_argument(message);
+        }
+    }
+
+    constexpr bool isDigit(char c) {
+        return (c >= '0') && (c <= '9');
+    }
+
+    constexpr bool isAlpha(char c) {
+        return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+    }
+
+    constexpr bool isTokenChar(char c) {
+        return isAlpha(c) || isDigit(c) || (c == '_');
+    }
+
+    constexpr bool isOctal(char c) {
+        return (c >= '0') && (c <= '7');
+    }
+
+    constexpr bool isHex(char c) {
+        return isDigit(c) || ((c >= 'a') && (c <= 'f')) || ((c >= 'A') && (c <= 'F'));
+    }
+
+    constexpr int hexValue(char c) {
+        return isDigit(c) ? (c - '0') : ((c | 0x20) - 'a' + 10);
+    }
+
+    constexpr bool isSpace(char c) {
+        return (c == ' ') || ((c >= '\t') && (c <= '\r'))
+                || ((static_cast<unsigned char>(c) < 0x20) && (c != '\0'));
+    }
+
+    template <size_t Rows, size_t Columns, size_t Capacity>
+    class Parser
+    {
+    public:
+        using Table = StaticTable<Rows, Columns, Capacity>;
+
+        constexpr explicit Parser(std::string_view source_): source(source_) {}
+
+        constexpr Table parse() {
+            skip();
+            readLeftAssignment();
+            readType();
+            readIdentifier();
+            readSizing();
+            readAssignment();
+            readTable();
+            return result;
+        }
+
+    protected:
+        constexpr char at(size_t offset = 0) const {
+            return (pos + offset) < source.size() ? source[pos + offset] : '\0';
+        }
+
+        constexpr std::string_view token() const {
+            size_t length = 0;
+            while (isTokenChar(at(length))) {
+                ++length;
+            }
+            return source.substr(pos, length);
+        }
+
+        constexpr void skip() {
+            while (pos < source.size()) {
+                if (isSpace(at())) {
+                    ++pos;
+                } else if ((at() == '/') && (at(1) == '/')) {
+                    while ((pos < source.size()) && (at() != '\n')) {
+                        ++pos;
+                    }
+                } else if ((at() == '/') && (at(1) == '*')) {
+                    pos += 2;
+                    while ((pos < source.size()) && !((at() == '*') && (at(1) == '/'))) {
+                        ++pos;
+                    }
+                    expect(pos < source.size(), "Unterminated multi-line comment");
+                    pos += 2;
+                } else {
+                    break;
+                }
+            }
+        }
+
+        constexpr void consume(char c, const char *message) {
+            expect(at() == c, message);
+            ++pos;
+            skip();
+        }
+
+        constexpr void readLeftAssignment() {
+            while ((token() == "const") || (token() == "static") || (token() == "volatile")) {
+                pos += token().size();
+                skip();
+            }
+        }
+
+        constexpr void readType() {
+            expect(token() == "char", "Expected \"char\" type in beginning of expression");
+            pos += 4;
+            skip();
+            consume('*', "Expected '*' after char type");
+            result.pointerDepth = 1;
+            //optional char* or char** or char***
+            while ((at() == '*') && (result.pointerDepth < 3)) {
+                ++result.pointerDepth;
+                consume('*', "Expected '*'");
+            }
+        }
+
+        constexpr void readIdentifier() {
+            std::string_view name = token();
+            expect((!name.empty()) && (!isDigit(name[0])), "Expected identifier after type");
+            result.identifierSpan = store(name);
+            pos += name.size();
+            skip();
+        }
+
+        constexpr void readSizing() {
+            size_t *dimensions[] = {&result.declaredRows, &result.declaredColumns};
+            for (size_t *dimension : dimensions) {
+                if (at() != '[') {
+                    break;
+                }
+                consume('[', "Expected '['");
+                while (isDigit(at())) {
+                    (*dimension) = (*dimension) * 10 + static_cast<size_t>(at() - '0');
+                    ++pos;
+                }
+                skip();
+                consume(']', "Expected ']' after integer in sizing");
+            }
+        }
+
+        constexpr void readAssignment() {
+            consume('=', "Expected '=' after sizing or identifier");
+        }
+
+        constexpr void readTable() {
+            consume('{', "Expected '{' after identifier or sizing");
+            expect(at() == '{', "Expected '{' inside array");
+            while (at() == '{') {
+                expect(result.rows < Rows, "Table has more rows than Rows capacity");
+                consume('{', "Expected '{'");
+                expect(at() == '"', "Expected '\"' inside nested array");
+                size_t &columns = result.rowSizes[result.rows];
+                while (at() == '"') {
+                    expect(columns < Columns, "Row has more cells than Columns capacity");
+                    result.cells[result.rows][columns++] = readString();
+                    skip();
+                    if (at() != ',') {
+                        break;
+                    }
+                    consume(',', "Expected ','");
+                }
+                consume('}', "Expected '}' after strings of nested array");
+                ++result.rows;
+                if (at() == ',') {
+                    consume(',', "Expected ','");
+                }
+            }
+            consume('}', "Expected '}' after nested array");
+            expect(at() == ';', "Expected ';' after expression");
+        }
+
+        //same decoding as HWParser::readString(), its quirks included:
+        //run of backslashes escapes only the char after it,
+        //'"? are rejected even right after backslash
+        constexpr CellSpan readString() {
+            CellSpan span {used, 0};
+            ++pos;//opening quote
+            while (at() != '"') {
+                expect(pos < source.size(), "Unterminated string");
+                char c = at();
+                expect((c != '\'') && (c != '?'), "Found unescaped special symbol");
+                if (c != '\\') {
+                    append(c);
+                    ++pos;
+                    continue;
+                }
+                while (at() == '\\') {
+                    ++pos;
+                }
+                expect(pos < source.size(), "Unterminated string");
+                c = at();
+                expect((c != '\'') && (c != '"') && (c != '?'), "Found unescaped special symbol");
+                if ((c == '0') || (c == 'a') || (c == 'b') || (c == 'e') || (c == 'f')
+                        || (c == 'n') || (c == 'r') || (c == 't') || (c == 'v')) {
+                    //kept escaped like in HWParser::escapedMapping
+                    append('\\');
+                    append(c);
+                    ++pos;
+                } else if (isOctal(c)) {
+                    append(readNumber(3, 8));
+                } else if (((c == 'x') || (c == 'u') || (c == 'U')) && isHex(at(1))) {
+                    ++pos;
+                    append(readNumber(c == 'u' ? 4 : 8, 16));
+                } else {
+                    expect(false, "Incorrect escaping syntax");
+                }
+            }
+            ++pos;//closing quote
+            span.size = used - span.begin;
+            return span;
+        }
+
+        constexpr char readNumber(size_t maxDigits, int base) {
+            int value = 0;
+            for (size_t i = 0; i < maxDigits; ++i) {
+                const char c = at();
+                if ((base == 8) ? (!isOctal(c)) : (!isHex(c))) {
+                    break;
+                }
+                value = (value * base + hexValue(c)) & 0xFF;
+                ++pos;
+            }
+            return static_cast<char>(value);
+        }
+
+        constexpr void append(char c) {
+            expect(used < Capacity, "Storage capacity exceeded");
+            result.storage[used++] = c;
+        }
+
+        constexpr CellSpan store(std::string_view str) {
+            CellSpan span {used, str.size()};
+            for (char c : str) {
+                append(c);
+            }
+            return span;
+        }
+
+        std::string_view source;
+        size_t pos = 0;
+        size_t used = 0;
+        Table result {};
+    };
+
+    template <size_t Rows, size_t Columns, size_t N>
+    constexpr StaticTable<Rows, Columns, N> parse(const char (&source)[N]) {
+        return Parser<Rows, Columns, N>(std::string_view(source, N - 1)).parse();
+    }
+}
+
+#endif // CONSTEXPR_PARSER_HPP
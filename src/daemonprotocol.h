@@ -0,0 +1,110 @@
+#ifndef DAEMON_PROTOCOL_H
+#define DAEMON_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+//Framing of ParseDaemon requests over Unix domain socket, shared with
+//ParserClient. Request is a header followed by payload:
+//    ParsePath   - payload is file path, daemon reads file itself
+//    ParseBuffer - payload is source, at most maxPayload bytes
+//    ParseMemfd  - no payload, source is in memfd passed with header,
+//                  sealed with at least F_SEAL_SHRINK and F_SEAL_WRITE
+//Response is a header followed by JSON of all tables.
+namespace daemon_protocol {
+    const uint32_t magic = 0x44505748;//"HWPD"
+    //payload is buffered by daemon, larger sources go as path or memfd
+    const uint64_t maxPayload = uint64_t(64) << 20;
+
+    enum RequestType : uint32_t { ParsePath = 1, ParseBuffer = 2, ParseMemfd = 3 };
+    enum Status : uint32_t { Ok = 0, BadRequest = 1, IoError = 2 };
+
+    struct Header {
+        uint32_t magic = daemon_protocol::magic;
+        //RequestType in requests, Status in responses
+        uint32_t kind = 0;
+        uint64_t size = 0;
+    };
+
+    inline bool writeAll(int fd, const void *data, size_t size) {
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0) {
+            ssize_t written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+            if (written <= 0) {
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    inline bool readAll(int fd, void *data, size_t size) {
+        char *bytes = static_cast<char *>(data);
+        while (size > 0) {
+            ssize_t count = ::recv(fd, bytes, size, 0);
+            if (count <= 0) {
+                return false;
+            }
+            bytes += count;
+            size -= static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    //header goes with optional descriptor in SCM_RIGHTS
+    inline bool sendHeader(int fd, const Header &header, int passedFd = -1) {
+        iovec data {const_cast<Header *>(&header), sizeof(header)};
+        msghdr message {};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        if (passedFd >= 0) {
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            cmsghdr *controlHeader = CMSG_FIRSTHDR(&message);
+            controlHeader->cmsg_level = SOL_SOCKET;
+            controlHeader->cmsg_type = SCM_RIGHTS;
+            controlHeader->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(controlHeader), &passedFd, sizeof(int));
+        }
+        return ::sendmsg(fd, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(header));
+    }
+
+    //passedFd is -1 if no descriptor came with header
+    inline bool receiveHeader(int fd, Header &header, int &passedFd) {
+        passedFd = -1;
+        iovec data {&header, sizeof(header)};
+        msghdr message {};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        ssize_t count = ::recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+        if (count <= 0) {
+            return false;
+        }
+        for (cmsghdr *controlHeader = CMSG_FIRSTHDR(&message); controlHeader != nullptr;
+             controlHeader = CMSG_NXTHDR(&message, controlHeader)) {
+            if ((controlHeader->cmsg_level == SOL_SOCKET)
+                    && (controlHeader->cmsg_type == SCM_RIGHTS)) {
+                std::memcpy(&passedFd, CMSG_DATA(controlHeader), sizeof(int));
+            }
+        }
+        //rest of header if it came in parts
+        if ((static_cast<size_t>(count) < sizeof(header))
+                && (!readAll(fd, reinterpret_cast<char *>(&header) + count,
+                             sizeof(header) - static_cast<size_t>(count)))) {
+            return false;
+        }
+        return header.magic == magic;
+    }
+}
+
+#endif // DAEMON_PROTOCOL_H
@@ -0,0 +1,123 @@
+#include "declarationindex.h"
+
+#include "hwparser.h"
+
+#include <filesystem>
+#include <fstream>
+
+DeclarationIndex DeclarationIndex::build(iter_type first, iter_type last)
+{
+    DeclarationIndex index;
+    HWParser parser(first, last);
+    index.entries = parser.index();
+    index.sourceSize = static_cast<size_t>(last - first);
+    index.rebuildLookup();
+    return index;
+}
+
+DeclarationIndex DeclarationIndex::forFile(const std::string &sourcePath,
+                                           iter_type first, iter_type last)
+{
+    namespace fs = std::filesystem;
+    const std::string indexPath = indexPathFor(sourcePath);
+    std::error_code error;
+    const auto sourceTime = fs::last_write_time(sourcePath, error);
+    if (!error) {
+        const auto indexTime = fs::last_write_time(indexPath, error);
+        DeclarationIndex index;
+        if ((!error) && (indexTime >= sourceTime) && index.load(indexPath)
+                && (index.sourceSize == static_cast<size_t>(last - first))) {
+            return index;
+        }
+    }
+    DeclarationIndex index = build(first, last);
+    //index is only a cache, failing to write it is not an error
+    index.save(indexPath);
+    return index;
+}
+
+std::string DeclarationIndex::indexPathFor(const std::string &sourcePath)
+{
+    return sourcePath + fileExtension;
+}
+
+bool DeclarationIndex::save(const std::string &path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file << fileMagic << ' ' << fileVersion << ' '
+         << sourceSize << ' ' << entries.size() << '\n';
+    for (auto &entry : entries) {
+        file << entry.identifier << ' ' << entry.pointerDepth << ' '
+             << entry.declaredRows << ' ' << entry.declaredColumns << ' '
+             << entry.beginIdx << ' ' << entry.endIdx << '\n';
+    }
+    return bool(file);
+}
+
+bool DeclarationIndex::load(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string magic;
+    int version = 0;
+    size_t count = 0;
+    if (!(file >> magic >> version >> sourceSize >> count)
+            || (magic != fileMagic) || (version != fileVersion)) {
+        return false;
+    }
+    entries.clear();
+    entries.reserve(count);
+    Declaration entry;
+    while ((entries.size() < count)
+           && (file >> entry.identifier >> entry.pointerDepth
+               >> entry.declaredRows >> entry.declaredColumns
+               >> entry.beginIdx >> entry.endIdx)) {
+        entries.push_back(entry);
+    }
+    if (entries.size() != count) {
+        entries.clear();
+        return false;
+    }
+    rebuildLookup();
+    return true;
+}
+
+const std::vector<Declaration> &DeclarationIndex::declarations() const
+{
+    return entries;
+}
+
+const Declaration *DeclarationIndex::find(std::string_view identifier) const
+{
+    auto iter = lookup.find(std::string(identifier));
+    return iter != lookup.end() ? &entries[iter->second] : nullptr;
+}
+
+ParseResult DeclarationIndex::parse(iter_type first, iter_type last,
+                                    std::string_view identifier) const
+{
+    const Declaration *declaration = find(identifier);
+    if ((declaration == nullptr)
+            || (declaration->endIdx > static_cast<size_t>(last - first))) {
+        ParseResult result;
+        result.output = "Declaration " + std::string(identifier) + " not found\n";
+        return result;
+    }
+    HWParser parser(first + declaration->beginIdx, first + declaration->endIdx);
+    ParseResult result = parser.parse();
+    result.tableBeginIdx += declaration->beginIdx;
+    result.tableEndIdx += declaration->beginIdx;
+    return result;
+}
+
+void DeclarationIndex::rebuildLookup()
+{
+    lookup.clear();
+    lookup.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        //first declaration wins, like in parse()
+        lookup.emplace(entries[i].identifier, i);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef DECLARATIONINDEX_H
+#define DECLARATIONINDEX_H
+
+#include "parseresult.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//Index of top-level table declarations of one source, lets parse
+//a single named table without parsing everything before it.
+//Can be saved next to the source and reused while source is unchanged.
+class DeclarationIndex
+{
+public:
+    using iter_type = const char*;
+
+    DeclarationIndex() = default;
+    //Api
+    static DeclarationIndex build(iter_type first, iter_type last);
+    //loads index saved next to source or builds and saves a new one
+    static DeclarationIndex forFile(const std::string &sourcePath,
+                                    iter_type first, iter_type last);
+    static std::string indexPathFor(const std::string &sourcePath);
+
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+
+    const std::vector<Declaration> &declarations() const;
+    const Declaration *find(std::string_view identifier) const;
+    //parses only the range of declaration, indices in result are absolute
+    ParseResult parse(iter_type first, iter_type last,
+                      std::string_view identifier) const;
+
+protected:
+    //Inner api
+    void rebuildLookup();
+    //Static data
+    inline static const std::string fileExtension {".hwidx"};
+    inline static const std::string fileMagic {"hwidx"};
+    inline static const int fileVersion = 2;
+    //Data
+    std::vector<Declaration> entries;
+    std::unordered_map<std::string, size_t> lookup;
+    size_t sourceSize = 0;
+};
+
+#endif // DECLARATIONINDEX_H
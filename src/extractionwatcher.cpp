@@ -0,0 +1,177 @@
+#include "extractionwatcher.h"
+#include "memorystats.h"
+
+ExtractionWatcher::ExtractionWatcher(BatchParser &parser_, const QStringList &paths,
+                                     QObject *parent)
+    : QObject(parent)
+    , parser(parser_)
+{
+    for (auto &path : paths) {
+        roots.append(QFileInfo(path).absoluteFilePath());
+    }
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(20);
+
+    connect(&watcher, &QFileSystemWatcher::fileChanged,
+            this, &ExtractionWatcher::onFileChanged);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged,
+            this, &ExtractionWatcher::onDirectoryChanged);
+    connect(&debounceTimer, &QTimer::timeout,
+            this, &ExtractionWatcher::extractPending);
+}
+
+void ExtractionWatcher::setOutputDir(const QString &dir)
+{
+    outputDir = dir.isEmpty() ? dir : QFileInfo(dir).absoluteFilePath();
+}
+
+void ExtractionWatcher::setDebounce(int msec)
+{
+    debounceTimer.setInterval(msec);
+}
+
+void ExtractionWatcher::setStatsEnabled(bool enabled)
+{
+    statsEnabled = enabled;
+}
+
+void ExtractionWatcher::start(bool watch)
+{
+    for (auto &root : roots) {
+        if (watch && QFileInfo(root).isDir()) {
+            watchDirectory(root);
+        }
+        for (auto &file : BatchParser::sourceFiles(root)) {
+            if (watch) {
+                watchFile(file);
+            }
+            extract(file);
+        }
+    }
+}
+
+void ExtractionWatcher::onFileChanged(const QString &path)
+{
+    if (pending.isEmpty()) {
+        latencyTimer.start();
+    }
+    //editors replacing file on save drop it from watcher,
+    //extractPending() adds it again
+    watchedFiles.remove(path);
+    pending.insert(path);
+    //burst of writes from one save is handled once
+    debounceTimer.start();
+}
+
+void ExtractionWatcher::onDirectoryChanged(const QString &path)
+{
+    if (!QFileInfo::exists(path)) {
+        //removed directory is dropped from watcher
+        watchedDirs.remove(path);
+        return;
+    }
+    QDirIterator iter(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    while (iter.hasNext()) {
+        const QString entry = iter.next();
+        if (iter.fileInfo().isDir()) {
+            if (!watchedDirs.contains(entry)) {
+                watchDirectory(entry);
+                for (auto &file : BatchParser::sourceFiles(entry)) {
+                    onFileChanged(file);
+                }
+            }
+        } else if (BatchParser::isSourceFile(entry) && (!watchedFiles.contains(entry))) {
+            onFileChanged(entry);
+        }
+    }
+}
+
+void ExtractionWatcher::extractPending()
+{
+    const QSet<QString> files = pending;
+    pending.clear();
+    for (auto &file : files) {
+        if (QFileInfo::exists(file)) {
+            watchFile(file);
+            extract(file);
+        } else {
+            parser.removeFile(file);
+            watcher.removePath(file);
+            watchedFiles.remove(file);
+            if (!outputDir.isEmpty()) {
+                QFile::remove(outputPathFor(file));
+            }
+            emit fileRemoved(file);
+        }
+    }
+    qInfo().noquote() << QString("Extracted %1 file(s) in %2 ms")
+                         .arg(files.size()).arg(latencyTimer.elapsed());
+}
+
+void ExtractionWatcher::watchDirectory(const QString &dir)
+{
+    watcher.addPath(dir);
+    watchedDirs.insert(dir);
+    QDirIterator iter(dir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (iter.hasNext()) {
+        const QString subdir = iter.next();
+        watcher.addPath(subdir);
+        watchedDirs.insert(subdir);
+    }
+}
+
+void ExtractionWatcher::watchFile(const QString &path)
+{
+    if (!watchedFiles.contains(path)) {
+        watcher.addPath(path);
+        watchedFiles.insert(path);
+    }
+}
+
+void ExtractionWatcher::extract(const QString &path)
+{
+    MemoryStats::Scope scope;
+    SourceCache::ResultPtr result = parser.parseFile(path);
+    if (statsEnabled) {
+        const AllocationStats allocations = scope.stats();
+        TableMemory memory;
+        for (auto &table : result->tables) {
+            memory += MemoryStats::tableMemory(table);
+        }
+        qInfo().noquote() << QString("%1: %2; %3").arg(path)
+                             .arg(QString::fromStdString(MemoryStats::format(memory)))
+                             .arg(QString::fromStdString(MemoryStats::format(allocations)));
+    }
+    const QString output = BatchParser::formatFile(*result);
+    writeOutput(path, output);
+    emit fileExtracted(path, output);
+}
+
+void ExtractionWatcher::writeOutput(const QString &path, const QString &output)
+{
+    if (outputDir.isEmpty()) {
+        QTextStream stream(stdout);
+        stream << output;
+        return;
+    }
+    const QString outputPath = outputPathFor(path);
+    QDir().mkpath(QFileInfo(outputPath).absolutePath());
+    QFile file(outputPath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QTextStream stream(&file);
+        stream << output;
+    } else {
+        qWarning().noquote() << QString("Can't write to file %1").arg(outputPath);
+    }
+}
+
+QString ExtractionWatcher::outputPathFor(const QString &path) const
+{
+    //keep layout of watched directories inside output directory
+    for (auto &root : roots) {
+        if (QFileInfo(root).isDir() && path.startsWith(root + '/')) {
+            return QDir(outputDir).filePath(QDir(root).relativeFilePath(path) + ".table");
+        }
+    }
+    return QDir(outputDir).filePath(QFileInfo(path).fileName() + ".table");
+}
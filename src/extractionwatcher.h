@@ -0,0 +1,55 @@
+#ifndef EXTRACTIONWATCHER_H
+#define EXTRACTIONWATCHER_H
+
+#include "batchparser.h"
+
+#include <QtCore>
+
+//Long-running extraction, after initial parse of all files only
+//files changed on disk are parsed again (inotify on Linux)
+class ExtractionWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    ExtractionWatcher(BatchParser &parser_, const QStringList &paths,
+                      QObject *parent = nullptr);
+
+    void setOutputDir(const QString &dir);
+    void setDebounce(int msec);
+    //print memory held by tables and allocations of every parse
+    void setStatsEnabled(bool enabled);
+    //extracts all files, then watches them if asked
+    void start(bool watch = true);
+
+signals:
+    void fileExtracted(const QString &path, const QString &output);
+    void fileRemoved(const QString &path);
+
+protected slots:
+    void onFileChanged(const QString &path);
+    void onDirectoryChanged(const QString &path);
+    void extractPending();
+
+protected:
+    void watchDirectory(const QString &dir);
+    void watchFile(const QString &path);
+    void extract(const QString &path);
+    void writeOutput(const QString &path, const QString &output);
+    QString outputPathFor(const QString &path) const;
+
+private:
+    BatchParser &parser;
+    QStringList roots;
+    QString outputDir;
+    QFileSystemWatcher watcher;
+    //mirror watcher.files() and directories() for constant time lookups
+    QSet<QString> watchedFiles;
+    QSet<QString> watchedDirs;
+    QTimer debounceTimer;
+    QElapsedTimer latencyTimer;
+    QSet<QString> pending;
+    bool statsEnabled = false;
+};
+
+#endif // EXTRACTIONWATCHER_H
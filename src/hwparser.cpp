@@ -1,23 +1,51 @@
 #include "hwparser.h"
 
 #include "macro.h"
+#include "structuralindex.h"
+#include "constexprparser.hpp"
 
 #include <cctype>
 #include <sstream>
 #include <algorithm>
+#include <limits>
+#include <atomic>
+#include <thread>
 
 HWParser::HWParser(iter_type first_, iter_type last_):
-    first(first_), last(last_), current(first_) {}
+    HWParser(first_, last_, Options()) {}
+
+HWParser::HWParser(iter_type first_, iter_type last_, Options options_):
+    first(first_), last(last_), current(first_), options(options_) {}
+
+void HWParser::reset(iter_type first_, iter_type last_)
+{
+    first = first_;
+    last = last_;
+    current = first_;
+}
 
 ParseResult HWParser::parse()
 {
     ParseResult result;
     stringstream out(result.output);
+    start(result, out);
+    run(Context::Done);
+    result.output = out.str();
+    return result;
+}
+
+void HWParser::start(ParseResult &result, stringstream &out)
+{
     ctx = {};
+    current = first;
+    includes.clear();
     ctx.resPtr = &result;
     ctx.outPtr = &out;
+}
 
-    while (ctx.shouldContinue) {
+void HWParser::run(Context::TableStage stopStage)
+{
+    while (ctx.shouldContinue && (ctx.stage != stopStage)) {
         if (isEnd()) {
             break;//loop
         }
@@ -69,7 +97,7 @@ ParseResult HWParser::parse()
             if (!readTable()) {
                 ctx.shouldContinue = false;
             } else {
-                result.ok = true;
+                ctx.resPtr->ok = true;
                 ctx.stage = Context::Done;
             }
             break;//switch
@@ -79,7 +107,107 @@ ParseResult HWParser::parse()
             ctx.shouldContinue = false;
         }
     }
-    return result;
+}
+
+const vector<string> &HWParser::includedFiles() const
+{
+    return includes;
+}
+
+vector<Declaration> HWParser::index()
+{
+    vector<Declaration> declarations;
+    scanDeclarations([this, &declarations](Declaration &declaration, ParseResult &) {
+        skipStatement(true);
+        if (!isEnd()) {
+            step();//past ';'
+        }
+        declaration.endIdx = pos();
+        declarations.push_back(std::move(declaration));
+    });
+    return declarations;
+}
+
+vector<ParseResult> HWParser::query(const Query &query)
+{
+    vector<ParseResult> results;
+    scanDeclarations([this, &query, &results](Declaration &declaration, ParseResult &result) {
+        if (!query.matches(declaration)) {
+            //fast-forward, nothing is decoded
+            skipStatement(true);
+            if (!isEnd()) {
+                step();//past ';'
+            }
+            return;
+        }
+        result.ok = readTable();
+        if (!result.ok) {
+            ctx.isSingleQuotes = false;
+            ctx.isDoubleQuotes = false;
+            skipStatement(true);
+            if (!isEnd()) {
+                step();
+            }
+        }
+        result.output = ctx.outPtr->str();
+        ctx.outPtr->str({});
+        results.push_back(std::move(result));
+    });
+    return results;
+}
+
+bool HWParser::Query::matches(const Declaration &declaration) const
+{
+    return (identifier.empty() || (identifier == declaration.identifier))
+            && ((pointerDepth == 0) || (pointerDepth == declaration.pointerDepth))
+            && ((declaredRows == 0) || (declaredRows == declaration.declaredRows))
+            && ((declaredColumns == 0) || (declaredColumns == declaration.declaredColumns))
+            && ((!predicate) || predicate(declaration));
+}
+
+template <typename OnDeclaration>
+void HWParser::scanDeclarations(OnDeclaration onDeclaration)
+{
+    ParseResult result;
+    stringstream out;
+    start(result, out);
+    while (!isEnd()) {
+        skip();
+        if (isEnd()) {
+            break;//loop
+        }
+        if (((*current) == '#') && isLineStart()) {
+            //directive ends at its line end, not at the next ';'
+            skipDirective();
+            continue;
+        }
+        const iter_type statementBegin = current;
+        result = ParseResult();
+        ctx.stage = Context::NoTable;
+        run(Context::Table);
+        if ((ctx.stage == Context::Table) && (!isEnd()) && ((*current) == '{')) {
+            Declaration declaration;
+            declaration.identifier = result.identifier;
+            declaration.pointerDepth = result.pointerDepth;
+            declaration.declaredRows = result.declaredRows;
+            declaration.declaredColumns = result.declaredColumns;
+            declaration.beginIdx = static_cast<size_t>(statementBegin - first);
+            //callback moves past the statement
+            onDeclaration(declaration, result);
+        } else {
+            //not a table, resync at the end of statement
+            current = statementBegin;
+            ctx.shouldContinue = true;
+            ctx.isSingleQuotes = false;
+            ctx.isDoubleQuotes = false;
+            skipStatement();
+            if (!isEnd()) {
+                step();
+            }
+        }
+        out.str({});
+        ctx.shouldContinue = true;
+    }
 }
 
 bool HWParser::readLeftAssignment()
@@ -99,6 +227,7 @@ bool HWParser::readType()
     if ((isSpecialState()) || (peek(charTypeStr.size()) != charTypeStr)) {
         (*ctx.outPtr) << "Expected \"char\" type"
                " in beginning of expression, got: " << token() << '\n';
+        return false;
     }
     ctx.resPtr->tableBeginIdx = pos();
     moveBy(charTypeStr.size());
@@ -108,9 +237,11 @@ bool HWParser::readType()
     }
     step();
     skip();
+    ctx.resPtr->pointerDepth = 1;
     //optional char* or char** or char***
     TIMES(2) {
-        if (token() == "*") {
+        if ((*current) == '*') {
+            ++ctx.resPtr->pointerDepth;
             step();
             skip();
         }
@@ -125,13 +256,16 @@ bool HWParser::readIdentifier()
         (*ctx.outPtr) << "Expected identifier after type, got: " << tokenStr << '\n';
         return false;
     }
+    ctx.resPtr->identifier.assign(tokenStr);
     moveBy(tokenStr.size());
     return true;
 }
 
 bool HWParser::readSizing()
 {
-    TIMES(2) {
+    size_t *dimensions[] = {&ctx.resPtr->declaredRows,
+                            &ctx.resPtr->declaredColumns};
+    for (size_t *dimension : dimensions) {
         if ((*current) == '[') {
             step();
             skip();
@@ -140,13 +274,16 @@ bool HWParser::readSizing()
                 (*ctx.outPtr) << "Expected integer after '[' in sizing, got: " << tokenStr << '\n';
                 return false;
             }
-            step();
+            //empty brackets leave dimension undeclared
+            (*dimension) = toSize(tokenStr);
+            moveBy(tokenStr.size());
             skip();
             if ((*current) != ']') {
                 (*ctx.outPtr) << "Expected ']' after integer in sizing, got: " << tokenStr << '\n';
                 return false;
             }
             step();
+            skip();
         }
     }
     return true;
@@ -165,8 +302,232 @@ bool HWParser::readAssignment()
 
 bool HWParser::readTable()
 {
+    ParseResult &result = *ctx.resPtr;
+    StringTable &table = result.table;
+    DenseStringTable &denseTable = result.denseTable;
+    //declared sizes are only hints, literal may be smaller or larger
+    const iter_type tableStart = current;
+    const auto outputMark = ctx.outPtr->tellp();
+    if (isParallelTable() && readParallelTable()) {
+        result.tableHash = hashRows(result.rowHashes);
+        return readTableEnd();
+    }
+    if (!readTableBegin()) {
+        return false;
+    }
+    const bool dense = isDenseStorage();
+    const size_t rowsHint = std::min(result.declaredRows, maxRowsLeft());
+    const size_t columnsHint = std::min(result.declaredColumns, maxCellsLeft());
+    if (dense) {
+        denseTable.rows = result.declaredRows;
+        denseTable.columns = result.declaredColumns;
+        denseTable.cells.resize(static_cast<int>(denseTable.rows * denseTable.columns));
+    } else {
+        table.reserve(static_cast<int>(rowsHint));
+    }
+    if (options.internCells) {
+        internedIds.clear();
+        result.idTable.reserve(static_cast<int>(rowsHint));
+    }
+    result.rowHashes.reserve(static_cast<int>(rowsHint));
+    size_t rowIdx = 0;
+    bool overflow = false;
+    //next array or strings
+    while (((*current) == '{') && (!overflow)) {
+        //hashed while cell bytes are still in cache
+        uint64_t rowHash = hashSeed;
+        IdRow *ids = nullptr;
+        if (options.internCells) {
+            result.idTable.append(IdRow());
+            ids = &result.idTable.back();
+            ids->reserve(static_cast<int>(columnsHint));
+        }
+        if (dense) {
+            if (rowIdx == denseTable.rows) {
+                overflow = true;
+                break;//to fallback
+            }
+            size_t cellIdx = 0;
+            auto toDense = [&](std::string_view, std::string &cell) {
+                if (cellIdx == denseTable.columns) {
+                    overflow = true;
+                    return;
+                }
+                denseTable.cells[static_cast<int>(rowIdx * denseTable.columns + cellIdx)]
+                        = makeCell(cell, ids);
+                rowHash = hashCell(rowHash, cell);
+                ++cellIdx;
+            };
+            if (!readCells(cellBuffer, toDense, true)) {
+                return false;
+            }
+        } else {
+            table.append(StringRow());
+            StringRow &currentRow = table.back();
+            currentRow.reserve(static_cast<int>(columnsHint));
+            auto toRow = [&](std::string_view, std::string &cell) {
+                currentRow.append(makeCell(cell, ids));
+                rowHash = hashCell(rowHash, cell);
+            };
+            if (!readCells(cellBuffer, toRow, true)) {
+                return false;
+            }
+        }
+        result.rowHashes.append(rowHash);
+        ++rowIdx;
+    }//after all rows
+    if (overflow) {
+        //literal doesn't fit declared shape, reread it as ragged table
+        current = tableStart;
+        ctx.isDoubleQuotes = false;
+        ctx.denseFallback = true;
+        ctx.outPtr->seekp(outputMark);
+        denseTable = {};
+        result.dictionary.clear();
+        result.idTable.clear();
+        result.rowHashes.clear();
+        return readTable();
+    }
+    result.isDense = dense;
+    result.tableHash = hashRows(result.rowHashes);
+    return readTableEnd();
+}
+
+bool HWParser::readParallelTable()
+{
+    //first stage, structural characters outside of strings
+    StructuralIndex index;
+    if (((*current) != '{') || (!index.build(current, last))) {
+        return false;
+    }
+    //second stage, rows are ranges of depth 2 braces
+    struct RowRange {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    vector<RowRange> rows;
+    rows.reserve(std::min(ctx.resPtr->declaredRows, maxRowsLeft()));
+    int depth = 0;
+    size_t tableEnd = 0;
+    for (size_t offset : index.positions()) {
+        const char c = current[offset];
+        if (c == '{') {
+            ++depth;
+            if (depth == 2) {
+                rows.push_back({offset, 0});
+            } else if (depth > 2) {
+                return false;
+            }
+        } else if (c == '}') {
+            --depth;
+            if (depth == 1) {
+                rows.back().end = offset;
+            } else if (depth == 0) {
+                tableEnd = offset;
+                break;//loop
+            }
+        } else if (c == ';') {
+            return false;
+        }
+    }
+    if ((tableEnd < parallelMinBytes) || rows.empty()) {
+        return false;
+    }
+    //only spaces and one optional ',' after a row are allowed at depth 1,
+    //anything else is left to sequential parser which reports it
+    auto isRowGap = [this](size_t begin, size_t end, bool isCommaAllowed) {
+        for (size_t offset = begin; offset < end; ++offset) {
+            const unsigned char c = static_cast<unsigned char>(current[offset]);
+            if ((c == ',') && isCommaAllowed) {
+                isCommaAllowed = false;
+            } else if (!(std::isspace(c) || std::iscntrl(c))) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!isRowGap(1, rows.front().begin, false)) {
+        return false;
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const size_t gapEnd = (i + 1 < rows.size()) ? rows[i + 1].begin : tableEnd;
+        if (!isRowGap(rows[i].end + 1, gapEnd, true)) {
+            return false;
+        }
+    }
+    //rows are decoded into preallocated slots, chunks go to workers
     StringTable &table = ctx.resPtr->table;
-    StringRow *currentRow = nullptr;
+    table.resize(static_cast<int>(rows.size()));
+    StringRow *slots = table.data();
+    QVector<uint64_t> &rowHashes = ctx.resPtr->rowHashes;
+    rowHashes.resize(static_cast<int>(rows.size()));
+    uint64_t *hashSlots = rowHashes.data();
+    std::atomic<size_t> nextRow {0};
+    std::atomic<bool> failed {false};
+    auto work = [&]() {
+        ParseResult scratch;
+        stringstream out;
+        HWParser rowParser(current, last, options);
+        //exception can't leave thread, sequential parser rethrows it
+        try {
+            for (size_t chunkBegin = nextRow.fetch_add(parallelChunkRows);
+                 (chunkBegin < rows.size()) && (!failed);
+                 chunkBegin = nextRow.fetch_add(parallelChunkRows)) {
+                const size_t chunkEnd = std::min(chunkBegin + parallelChunkRows, rows.size());
+                for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                    rowParser.reset(current + rows[i].begin, current + rows[i].end + 1);
+                    rowParser.start(scratch, out);
+                    if (!rowParser.readRow(slots[i], &hashSlots[i])) {
+                        failed = true;
+                        break;//loop
+                    }
+                }
+            }
+        } catch (...) {
+            failed = true;
+        }
+    };
+    const size_t workersCount = std::min<size_t>(options.parallelThreads,
+                                                 (rows.size() + parallelChunkRows - 1)
+                                                 / parallelChunkRows);
+    vector<std::thread> workers;
+    //calling thread is a worker too
+    for (size_t i = 1; i < workersCount; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (failed) {
+        //sequential parse reports the error
+        table.clear();
+        rowHashes.clear();
+        return false;
+    }
+    current += tableEnd;
+    return true;
+}
+
+QString HWParser::makeCell(const std::string &bytes, IdRow *ids)
+{
+    //bytes are appended as Latin1 like in QTextStream
+    if (!options.internCells) {
+        return QString::fromLatin1(bytes.data(), static_cast<int>(bytes.size()));
+    }
+    auto iter = internedIds.find(bytes);
+    if (iter == internedIds.end()) {
+        iter = internedIds.emplace(bytes, ctx.resPtr->dictionary.size()).first;
+        ctx.resPtr->dictionary.append(
+                    QString::fromLatin1(bytes.data(), static_cast<int>(bytes.size())));
+    }
+    ids->append(iter->second);
+    //implicitly shared copy, repeated cells hold no payload of their own
+    return ctx.resPtr->dictionary.at(iter->second);
+}
+
+bool HWParser::readTableBegin()
+{
     //begin of array or arrays
     if ((*current) != '{') {
         (*ctx.outPtr) << "Expected '{' after identifier or sizing, got: " << token() << '\n';
@@ -178,46 +539,57 @@ bool HWParser::readTable()
         (*ctx.outPtr) << "Expected '{' inside array, got: " << token() << '\n';
         return false;
     }
-    //next array or strings
-    while ((*current) == '{') {
-        table.append(StringRow());
-        currentRow = &table.back();
+    return true;
+}
 
-        step();
-        skip();
-        if ((*current) != '"') {
-            (*ctx.outPtr) << "Expected '\"' inside nested array, got: " << token() << '\n';
-            return false;
+template <typename String, typename OnCell>
+bool HWParser::readCells(String &tableStr, OnCell onCell, bool decode)
+{
+    step();
+    skip();
+    if ((*current) != '"') {
+        (*ctx.outPtr) << "Expected '\"' inside nested array, got: " << token() << '\n';
+        return false;
+    }
+    //next string
+    while ((*current) == '"') {
+        const iter_type cellBegin = current + 1;
+        ctx.isDoubleQuotes = true;
+        tableStr.clear();
+        if (!decode) {
+            skipString();
+            ctx.isDoubleQuotes = false;
+        } else if (!readString(tableStr)) {
+            skipToEndOfQuotes();
+        } else {
+            ctx.isDoubleQuotes = false;
         }
-        QString tableStr;
-        //next string
-        while ((*current) == '"') {
-            ctx.isDoubleQuotes = true;
-            tableStr = "";
-            if (!readString(tableStr)) {
-                skipToEndOfQuotes();
-            } else {
-                ctx.isDoubleQuotes = false;
-            }
-            currentRow->append(tableStr);
-            skip();
-            if ((*current) != ',') {
-                break;
-            }
-            step();
-            skip();
-        }//after all string of row
-        if ((*current) != '}') {
-            (*ctx.outPtr) << "Expected '}' after strings of nested array, got: " << token() << '\n';
-            return false;
+        //raw cell excludes closing quote
+        onCell(std::string_view(cellBegin, static_cast<size_t>(
+                                    std::max(current - 1, cellBegin) - cellBegin)),
+               tableStr);
+        skip();
+        if ((*current) != ',') {
+            break;
         }
         step();
         skip();
-        if ((*current) == ',') {
-            step();
-            skip();
-        }
-    }//after all rows
+    }//after all string of row
+    if ((*current) != '}') {
+        (*ctx.outPtr) << "Expected '}' after strings of nested array, got: " << token() << '\n';
+        return false;
+    }
+    step();
+    skip();
+    if ((*current) == ',') {
+        step();
+        skip();
+    }
+    return true;
+}
+
+bool HWParser::readTableEnd()
+{
     if ((*current) != '}') {
         (*ctx.outPtr) << "Expected '}' after nested array, got: " << token() << '\n';
         return false;
@@ -234,10 +606,60 @@ bool HWParser::readTable()
     return true;
 }
 
-bool HWParser::readString(QString &str)
+bool HWParser::readRow(StringRow &row, uint64_t *rowHash)
+{
+    uint64_t hash = hashSeed;
+    row.clear();
+    bool ok = readCells(cellBuffer, [&](std::string_view, std::string &cell) {
+        row.append(QString::fromLatin1(cell.data(), static_cast<int>(cell.size())));
+        hash = hashCell(hash, cell);
+    }, true);
+    if (rowHash != nullptr) {
+        (*rowHash) = hash;
+    }
+    return ok;
+}
+
+bool HWParser::readRow(PmrStringRow &row)
+{
+    row.clear();
+    return readCells(cellBuffer, [&row](std::string_view, std::string &cell) {
+        row.emplace_back(cell);
+    }, true);
+}
+
+bool HWParser::readRawRow(QVector<std::string_view> &row)
+{
+    QString tableStr;
+    row.clear();
+    return readCells(tableStr, [&row](std::string_view raw, QString &) {
+        row.append(raw);
+    }, false);
+}
+
+bool HWParser::readTable(PmrStringTable &table)
+{
+    ParseResult &result = *ctx.resPtr;
+    if (!readTableBegin()) {
+        return false;
+    }
+    table.reserve(std::min(result.declaredRows, maxRowsLeft()));
+    const size_t columnsHint = std::min(result.declaredColumns, maxCellsLeft());
+    while ((*current) == '{') {
+        PmrStringRow &row = table.emplace_back();
+        row.reserve(columnsHint);
+        if (!readRow(row)) {
+            return false;
+        }
+    }
+    return readTableEnd();
+}
+
+template <typename String>
+bool HWParser::readString(String &str)
 {
-    QTextStream stream(&str);
     step();
+    const iter_type stringBegin = current;
     while ((!isEnd()) &&
            !(((*current) == '"') && (*(current - 1) != '\\'))
            ) {
@@ -248,41 +670,42 @@ bool HWParser::readString(QString &str)
         if (symbolsToEscape.find(*current) != std::string::npos) {
             (*ctx.outPtr) << "Found unescaped special symbol '"
                           << (*current) << "', reading just partial string \""
-                          << str.toStdString() << "\"\n";
+                          << std::string_view(stringBegin, static_cast<size_t>(current - stringBegin))
+                          << "\"\n";
             return false;
         }
         auto iter = escapedMapping.find(*current);
         if ((*(current - 1)) == '\\') {
             if (iter != escapedMapping.end()) {
-                stream << iter->second.data();
+                str += iter->second.data();
                 step();
                 continue;
             }
             if (isOctal(*current)) {
-                auto str = peekNOctal(3);
-                stream << octal2char(str);
-                current += str.size();
+                auto digits = peekNOctal(3);
+                str += octal2char(digits);
+                current += digits.size();
                 continue;
             }
             if (((*current) == 'x') && isHex(*(current + 1))) {
                 step();
-                auto str = peekNHex(8);
-                stream << hex2char(str);
-                current += str.size();
+                auto digits = peekNHex(8);
+                str += hex2char(digits);
+                current += digits.size();
                 continue;
             }
             if (((*current) == 'u') && isHex(*(current + 1))) {
                 step();
-                auto str = peekNHex(4);
-                stream << hex2char(str);
-                current += str.size();
+                auto digits = peekNHex(4);
+                str += hex2char(digits);
+                current += digits.size();
                 continue;
             }
             if (((*current) == 'U') && isHex(*(current + 1))) {
                 step();
-                auto str = peekNHex(8);
-                stream << hex2char(str);
-                current += str.size();
+                auto digits = peekNHex(8);
+                str += hex2char(digits);
+                current += digits.size();
                 continue;
             }
             (*ctx.outPtr) << "Incorrect escaping syntax, found '"
@@ -290,13 +713,34 @@ bool HWParser::readString(QString &str)
             return false;
         }//if current char is right after \\
 
-        stream << (*current);
+        str += (*current);
         step();
     }//end of loop
     step();
     return true;
 }
 
+//constexpr_parser::Parser::readString() must stay in sync with the above
+namespace {
+    constexpr auto escapingSample = constexpr_parser::parse<1, 4>(
+            R"(char* t[] = {{"a\\b", "\101\x42\u0043", "\xFFFFFF44", "\0\n"}};)");
+    static_assert(escapingSample.cell(0, 0) == R"(a\b)");
+    static_assert(escapingSample.cell(0, 1) == "ABC");
+    static_assert(escapingSample.cell(0, 2) == "D");
+    static_assert(escapingSample.cell(0, 3) == R"(\0\n)");
+}
+
+void HWParser::skipString()
+{
+    step();
+    while ((!isEnd()) &&
+           !(((*current) == '"') && (*(current - 1) != '\\'))
+           ) {
+        step();
+    }
+    step();
+}
+
 std::string_view HWParser::peek(std::size_t count) const
 {
     return {current, count};
@@ -400,6 +844,73 @@ bool HWParser::isInteger(std::string_view str) const
     });
 }
 
+size_t HWParser::toSize(std::string_view str) const
+{
+    static const size_t maxValue = std::numeric_limits<size_t>::max();
+    size_t value = 0;
+    for (char c : str) {
+        size_t digit = static_cast<size_t>(c - '0');
+        if (value > (maxValue - digit) / 10) {
+            return maxValue;
+        }
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+size_t HWParser::maxRowsLeft() const
+{
+    //shortest row is {""},
+    return static_cast<size_t>(last - current) / 5;
+}
+
+size_t HWParser::maxCellsLeft() const
+{
+    //shortest cell is "",
+    return static_cast<size_t>(last - current) / 3;
+}
+
+uint64_t HWParser::hashCell(uint64_t hash, const std::string &bytes)
+{
+    //FNV-1a, length is mixed in so cell boundaries matter
+    for (char c : bytes) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * hashPrime;
+    }
+    return (hash ^ bytes.size()) * hashPrime;
+}
+
+uint64_t HWParser::hashRows(const QVector<uint64_t> &rowHashes)
+{
+    uint64_t hash = hashSeed;
+    for (uint64_t rowHash : rowHashes) {
+        //splitmix64 finalizer keeps row order significant
+        hash ^= rowHash + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+        hash ^= hash >> 31;
+    }
+    return hash;
+}
+
+bool HWParser::isParallelTable() const
+{
+    return (options.parallelThreads > 1) && (!options.internCells)
+            && (!isDenseStorage())
+            //table size is known only after first stage of readParallelTable()
+            && (static_cast<size_t>(last - current) >= parallelMinBytes);
+}
+
+bool HWParser::isDenseStorage() const
+{
+    const size_t rows = ctx.resPtr->declaredRows;
+    const size_t columns = ctx.resPtr->declaredColumns;
+    //bogus huge sizes can't be preallocated, keep ragged table for them,
+    //fixed cap so layout doesn't depend on text after the table
+    return options.denseStorage && (!ctx.denseFallback)
+            && (rows > 0) && (columns > 0)
+            && (rows <= options.maxDenseCells / columns);
+}
+
 bool HWParser::isSpecialState() const
 {
     return ctx.isOneLineComment || ctx.isMultiLineComment
@@ -417,6 +928,29 @@ bool HWParser::isEnd()
     return current >= last ? !(ctx.shouldContinue = false) : false;
 }
 
+bool HWParser::isLineStart() const
+{
+    iter_type iter = current;
+    while ((iter > first) && (((*(iter - 1)) == ' ') || ((*(iter - 1)) == '\t'))) {
+        --iter;
+    }
+    return (iter == first) || ((*(iter - 1)) == '\n');
+}
+
+bool HWParser::isLineContinued() const
+{
+    iter_type iter = current;
+    if ((iter > first) && ((*(iter - 1)) == '\r')) {
+        --iter;
+    }
+    return (iter > first) && ((*(iter - 1)) == '\\');
+}
+
+bool HWParser::isOnDirective() const
+{
+    return options.skipPreprocessor && ((*current) == '#') && isLineStart();
+}
+
 bool HWParser::isOnSingleQuote() const
 {
     return ((*current) == '\'') && ((*(current - 1)) != '\\');
@@ -432,6 +966,7 @@ bool HWParser::shouldSkip()
     return (!isEnd()) && (ctx.isOneLineComment || ctx.isMultiLineComment
             || (ctx.isOneLineComment = (peek(2) == "//"))
             || (ctx.isMultiLineComment = (peek(2) == "/*"))
+            || (ctx.isPreprocessor = isOnDirective())
             || isSpace());
 }
 
@@ -468,6 +1003,46 @@ void HWParser::skip()
             }
             ctx.isOneLineComment = false;
         }
+
+        if (ctx.isPreprocessor) {
+            skipDirective();
+            ctx.isPreprocessor = false;
+        }
+    }
+}
+
+void HWParser::skipDirective()
+{
+    const iter_type directiveBegin = current;
+    //directive ends at the first line end not escaped by '\'
+    while ((!isEnd()) && !(((*current) == '\n') && (!isLineContinued()))) {
+        step();
+    }
+    if (options.followIncludes) {
+        readInclude({directiveBegin, static_cast<size_t>(current - directiveBegin)});
+    }
+    if (!isEnd()) {
+        step();//don't point to '\n'
+    }
+}
+
+void HWParser::readInclude(std::string_view directive)
+{
+    static const std::string_view includeStr = "include";
+    static const std::string_view blanks = " \t";
+    //only local includes, system ones are never searched
+    size_t idx = directive.find_first_not_of(blanks, 1);
+    if ((idx == std::string_view::npos)
+            || (directive.substr(idx, includeStr.size()) != includeStr)) {
+        return;
+    }
+    idx = directive.find_first_not_of(blanks, idx + includeStr.size());
+    if ((idx == std::string_view::npos) || (directive[idx] != '"')) {
+        return;
+    }
+    size_t endIdx = directive.find('"', idx + 1);
+    if (endIdx != std::string_view::npos) {
+        includes.emplace_back(directive.substr(idx + 1, endIdx - idx - 1));
     }
 }
 
@@ -489,6 +1064,50 @@ void HWParser::skipTo(char c)
     }
 }
 
+void HWParser::skipStatement(bool isInitializer)
+{
+    int depth = 0;
+    while (!isEnd()) {
+        skip();
+        if (isEnd()) {
+            break;//loop
+        }
+        switch (*current) {
+        case '"':
+            skipString();
+            continue;
+        case '\'':
+            //char literal, may contain escaped quote
+            step();
+            while ((!isEnd()) && ((*current) != '\'')) {
+                moveBy((*current) == '\\' ? 2 : 1);
+            }
+            break;//switch
+        case '=':
+            isInitializer = isInitializer || (depth == 0);
+            break;//switch
+        case '{':
+            ++depth;
+            break;//switch
+        case '}':
+            --depth;
+            //function or struct body isn't followed by ';'
+            if ((depth <= 0) && (!isInitializer)) {
+                return;
+            }
+            break;//switch
+        case ';':
+            if (depth <= 0) {
+                return;
+            }
+            break;//switch
+        default:
+            break;//switch
+        }
+        step();
+    }
+}
+
 void HWParser::skipToEndOfQuotes()
 {
     if (ctx.isSingleQuotes) {
@@ -505,12 +1124,22 @@ void HWParser::skipToEndOfQuotes()
 
 char HWParser::octal2char(std::string_view str) const
 {
-    size_t pos = 0;
-    return static_cast<char>(std::stoi(string(str), &pos, 8));
+    //value is masked to a byte like in constexpr_parser::readNumber()
+    int value = 0;
+    for (char c : str) {
+        value = (value * 8 + (c - '0')) & 0xFF;
+    }
+    return static_cast<char>(value);
 }
 
 char HWParser::hex2char(std::string_view str) const
 {
-    size_t pos = 0;
-    return static_cast<char>(std::stoi(string(str), &pos, 16));
+    //masked as it goes, 8 digits would overflow int
+    int value = 0;
+    for (char c : str) {
+        const int digit = std::isdigit(static_cast<unsigned char>(c)) ? (c - '0')
+                                                                      : ((c | 0x20) - 'a' + 10);
+        value = (value * 16 + digit) & 0xFF;
+    }
+    return static_cast<char>(value);
 }
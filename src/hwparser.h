@@ -5,6 +5,9 @@
 
 #include <string_view>
 #include <map>
+#include <functional>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
@@ -13,20 +16,63 @@ class HWParser
 public:
     using iter_type = const char*;
 
+    struct Options {
+        //store fully sized tables in ParseResult::denseTable
+        bool denseStorage = false;
+        //larger declared shapes are read as ragged table
+        size_t maxDenseCells = size_t(1) << 24;
+        //skip # lines with continuations instead of resyncing at ';'
+        bool skipPreprocessor = false;
+        //collect #include "..." paths of skipped directives
+        bool followIncludes = false;
+        //equal cells share one string, fills dictionary and idTable
+        bool internCells = false;
+        //decode rows of large tables on this many threads
+        unsigned parallelThreads = 1;
+    };
+
+    //Declarations to extract, empty or zero fields match anything
+    struct Query {
+        string identifier;
+        int pointerDepth = 0;
+        size_t declaredRows = 0;
+        size_t declaredColumns = 0;
+        function<bool(const Declaration &)> predicate;
+
+        bool matches(const Declaration &declaration) const;
+    };
+
     HWParser(iter_type first_, iter_type last_);
+    HWParser(iter_type first_, iter_type last_, Options options_);
     //Api
+    //reuse parser for another source
+    void reset(iter_type first_, iter_type last_);
     ParseResult parse();
+    //fast skim over all top-level table declarations, tables aren't decoded
+    vector<Declaration> index();
+    //parses matching top-level tables only, others are skipped undecoded
+    vector<ParseResult> query(const Query &query);
+    //local includes met during last parse() or index() in source order
+    const vector<string> &includedFiles() const;
 
 protected:
     //Inner api
+    template <typename OnDeclaration>
+    inline void scanDeclarations(OnDeclaration onDeclaration);
     inline bool readLeftAssignment();
     inline bool readType();
     inline bool readIdentifier();
     inline bool readSizing();
     inline bool readAssignment();
     inline bool readTable();
+    template <typename String, typename OnCell>
+    inline bool readCells(String &tableStr, OnCell onCell, bool decode);
 
-    inline bool readString(QString &str);
+    template <typename String>
+    inline bool readString(String &str);
+    inline bool readParallelTable();
+    inline QString makeCell(const string &bytes, IdRow *ids);
+    inline void skipString();
 
     inline string_view peek(size_t count) const;
     inline string_view consume(size_t count);
@@ -43,23 +89,36 @@ protected:
     inline bool isHex(char c) const;
     inline bool isIdentifier(string_view str) const;
     inline bool isInteger(string_view str) const;
+    inline size_t toSize(string_view str) const;
+    inline size_t maxRowsLeft() const;
+    inline size_t maxCellsLeft() const;
 
     inline bool isSpecialState() const;
+    inline bool isDenseStorage() const;
+    inline bool isParallelTable() const;
+    static inline uint64_t hashCell(uint64_t hash, const string &bytes);
+    static inline uint64_t hashRows(const QVector<uint64_t> &rowHashes);
 
     inline bool isSpace() const;
     inline bool isEnd();
 
+    inline bool isLineStart() const;
+    inline bool isLineContinued() const;
+    inline bool isOnDirective() const;
     inline bool isOnSingleQuote() const;
     inline bool isOnDoubleQuote() const;
 
     inline bool shouldSkip();
     inline void skip();
     inline void skipTo(char c);
+    inline void skipStatement(bool isInitializer = false);
     inline void skipToEndOfQuotes();
+    inline void skipDirective();
+    inline void readInclude(string_view directive);
 
     inline char octal2char(string_view str) const;
     inline char hex2char(string_view str) const;
-    //Types
+
     struct Context {
         enum TableStage { NoTable = -1, Type, Identifier, Sizing,
                           Assignment, Table, Done };
@@ -67,16 +126,32 @@ protected:
         bool shouldContinue = true;
         bool isOneLineComment = false;
         bool isMultiLineComment = false;
+        bool isPreprocessor = false;
         bool isSingleQuotes = false;
         bool isDoubleQuotes = false;
+        bool denseFallback = false;
         ParseResult *resPtr = nullptr;
         stringstream *outPtr = nullptr;
         TableStage stage = NoTable;
     };
+    //Stepwise api for readers
+    void start(ParseResult &result, stringstream &out);
+    void run(Context::TableStage stopStage);
+    bool readTableBegin();
+    bool readRow(StringRow &row, uint64_t *rowHash = nullptr);
+    bool readRow(PmrStringRow &row);
+    bool readTable(PmrStringTable &table);
+    bool readRawRow(QVector<string_view> &row);
+    bool readTableEnd();
     //Static data
     inline static const vector<string> allowedKeyWordsModifiers {
         {"const"}, {"static"}, {"volatile"}
     };
+    //smaller tables are not worth starting threads
+    inline static const size_t parallelMinBytes = 1 << 20;
+    inline static const size_t parallelChunkRows = 1024;
+    inline static const uint64_t hashSeed = 0xcbf29ce484222325ULL;
+    inline static const uint64_t hashPrime = 0x100000001b3ULL;
     inline static const string otherTokenChars {"_"};
     inline static const string octalChars {"01234567"};
     inline static const string hexChars {"0123456789aAbBcCdDeEfF"};
@@ -91,7 +166,13 @@ protected:
     iter_type first;
     iter_type last;
     iter_type current;
+    Options options;
     Context ctx;
+    vector<string> includes;
+    //decoded bytes of current cell, reused between cells
+    string cellBuffer;
+    //dictionary index of every distinct cell of current table
+    unordered_map<string, int> internedIds;
 };
 
 #endif // HWPARSER_H
@@ -1,9 +1,13 @@
 #include "mainwindow.h"
+#include "cli.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    if (argc > 1) {
+        return runCommandLine(argc, argv);
+    }
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
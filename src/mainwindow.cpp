@@ -3,6 +3,8 @@
 
 #include "parser.hpp"
 #include "parseresult.h"
+#include "batchparser.h"
+#include "memorystats.h"
 
 #include <tuple>
 #include <sstream>
@@ -43,35 +45,19 @@ void MainWindow::parse()
     if (source.size() == 0) {
         return;
     }
-    const char* begin = qPrintable(source);
-    const char* end = begin + source.size();
+    //keep bytes alive while parsing, qPrintable() returns temporary
+    const QByteArray bytes = source.toLocal8Bit();
+    const char* begin = bytes.constData();
+    const char* end = begin + bytes.size();
 
+    MemoryStats::Scope scope;
     ParseResult result = parse_source(begin, end);
+    const AllocationStats allocations = scope.stats();
 
-    StringTable &table = result.table;
-    QString output = QString::fromStdString(result.output);
-    QTextStream stream(&output);
-    bool rowComma = false;
-    stream << "{\n";
-    for (auto &row : table) {
-        if (rowComma) {
-            stream << ",\n";
-        }
-        rowComma = true;
-        bool cellComma = false;
-        stream << "  {\n";
-        for (auto &cell : row) {
-            if (cellComma) {
-                stream << ",\n";
-            }
-            cellComma = true;
-            stream << "    \"" << cell << "\"";
-        }
-        stream << "\n  }";
-    }
-    stream << "};\n";
-
-    ui->parsedResultsEdit->setPlainText(output);
+    ui->parsedResultsEdit->setPlainText(BatchParser::formatTable(result));
+    ui->statusbar->showMessage(QString::fromStdString(
+                                   MemoryStats::format(MemoryStats::tableMemory(result))
+                                   + "; " + MemoryStats::format(allocations)));
 }
 
 void MainWindow::setupActions()
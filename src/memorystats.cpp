@@ -0,0 +1,252 @@
+#include "memorystats.h"
+
+#include <atomic>
+#include <cerrno>
+#include <sstream>
+#include <unordered_set>
+
+#if defined(PARSER_MEMORY_STATS) && defined(__GLIBC__)
+#define MEMORY_STATS_HOOK
+#include <malloc.h>
+#endif
+
+namespace {
+    std::atomic<size_t> allocationsCount {0};
+    std::atomic<size_t> freesCount {0};
+    std::atomic<size_t> allocatedBytes {0};
+    std::atomic<size_t> currentBytes {0};
+    std::atomic<size_t> peakBytes {0};
+}
+
+#ifdef MEMORY_STATS_HOOK
+//Interposes glibc allocator, so Qt containers are counted as well as new
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void *__libc_valloc(size_t size);
+    void *__libc_pvalloc(size_t size);
+    void __libc_free(void *ptr);
+
+    static void countAllocation(void *ptr)
+    {
+        if (ptr == nullptr) {
+            return;
+        }
+        const size_t size = malloc_usable_size(ptr);
+        allocationsCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        const size_t current = currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = peakBytes.load(std::memory_order_relaxed);
+        while ((current > peak)
+               && (!peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed))) {
+        }
+    }
+
+    static void countFreedBytes(size_t size)
+    {
+        freesCount.fetch_add(1, std::memory_order_relaxed);
+        currentBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    static void countFree(void *ptr)
+    {
+        if (ptr == nullptr) {
+            return;
+        }
+        countFreedBytes(malloc_usable_size(ptr));
+    }
+
+    void *malloc(size_t size)
+    {
+        void *ptr = __libc_malloc(size);
+        countAllocation(ptr);
+        return ptr;
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        void *ptr = __libc_calloc(count, size);
+        countAllocation(ptr);
+        return ptr;
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        //failed realloc keeps old block, size is taken before it's freed
+        const size_t oldSize = (ptr != nullptr) ? malloc_usable_size(ptr) : 0;
+        void *newPtr = __libc_realloc(ptr, size);
+        if ((ptr != nullptr) && ((newPtr != nullptr) || (size == 0))) {
+            countFreedBytes(oldSize);
+        }
+        countAllocation(newPtr);
+        return newPtr;
+    }
+
+    void *reallocarray(void *ptr, size_t count, size_t size)
+    {
+        size_t bytes = 0;
+        if (__builtin_mul_overflow(count, size, &bytes)) {
+            errno = ENOMEM;
+            return nullptr;
+        }
+        return realloc(ptr, bytes);
+    }
+
+    //aligned entry points must be counted too, or their frees are not
+    //balanced, aligned operator new ends up in aligned_alloc
+    void *memalign(size_t alignment, size_t size)
+    {
+        void *ptr = __libc_memalign(alignment, size);
+        countAllocation(ptr);
+        return ptr;
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        return memalign(alignment, size);
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size)
+    {
+        if ((alignment % sizeof(void *) != 0) || ((alignment & (alignment - 1)) != 0)) {
+            return EINVAL;
+        }
+        void *newPtr = memalign(alignment, size);
+        if (newPtr == nullptr) {
+            return ENOMEM;
+        }
+        (*ptr) = newPtr;
+        return 0;
+    }
+
+    void *valloc(size_t size)
+    {
+        void *ptr = __libc_valloc(size);
+        countAllocation(ptr);
+        return ptr;
+    }
+
+    void *pvalloc(size_t size)
+    {
+        void *ptr = __libc_pvalloc(size);
+        countAllocation(ptr);
+        return ptr;
+    }
+
+    void free(void *ptr)
+    {
+        countFree(ptr);
+        __libc_free(ptr);
+    }
+}
+#endif // MEMORY_STATS_HOOK
+
+MemoryStats::Scope::Scope()
+{
+    begin.allocations = allocationsCount.load();
+    begin.frees = freesCount.load();
+    begin.allocatedBytes = allocatedBytes.load();
+    beginBytes = currentBytes.load();
+    peakBytes.store(beginBytes);
+}
+
+AllocationStats MemoryStats::Scope::stats() const
+{
+    AllocationStats stats;
+    stats.allocations = allocationsCount.load() - begin.allocations;
+    stats.frees = freesCount.load() - begin.frees;
+    stats.allocatedBytes = allocatedBytes.load() - begin.allocatedBytes;
+    const size_t peak = peakBytes.load();
+    stats.peakBytes = peak > beginBytes ? peak - beginBytes : 0;
+    return stats;
+}
+
+bool MemoryStats::isEnabled()
+{
+#ifdef MEMORY_STATS_HOOK
+    return true;
+#else
+    return false;
+#endif
+}
+
+TableMemory MemoryStats::tableMemory(const ParseResult &result)
+{
+    //implicitly shared strings are counted once
+    std::unordered_set<const void *> strings;
+    TableMemory memory;
+    auto addString = [&](const QString &str) {
+        if ((str.capacity() > 0) && strings.insert(str.constData()).second) {
+            memory.payload += static_cast<size_t>(str.capacity() + 1) * sizeof(QChar);
+            memory.overhead += sizeof(QArrayData);
+        }
+    };
+    auto addVector = [&](const auto &vector, size_t &bytes) {
+        using Value = typename std::decay_t<decltype(vector)>::value_type;
+        if (vector.capacity() > 0) {
+            bytes += static_cast<size_t>(vector.capacity()) * sizeof(Value);
+            memory.overhead += sizeof(QArrayData);
+        }
+    };
+    addVector(result.table, memory.rows);
+    for (auto &row : result.table) {
+        addVector(row, memory.cells);
+        for (auto &cell : row) {
+            addString(cell);
+        }
+    }
+    addVector(result.denseTable.cells, memory.cells);
+    for (auto &cell : result.denseTable.cells) {
+        addString(cell);
+    }
+    addVector(result.dictionary, memory.cells);
+    for (auto &cell : result.dictionary) {
+        addString(cell);
+    }
+    addVector(result.idTable, memory.rows);
+    for (auto &row : result.idTable) {
+        addVector(row, memory.cells);
+    }
+    return memory;
+}
+
+std::string MemoryStats::format(const TableMemory &memory)
+{
+    std::ostringstream out;
+    out << "table " << formatBytes(memory.total())
+        << " (rows " << formatBytes(memory.rows)
+        << ", cells " << formatBytes(memory.cells)
+        << ", payload " << formatBytes(memory.payload)
+        << ", overhead " << formatBytes(memory.overhead) << ")";
+    return out.str();
+}
+
+std::string MemoryStats::format(const AllocationStats &stats)
+{
+    if (!isEnabled()) {
+        return "allocations not counted, build with PARSER_MEMORY_STATS";
+    }
+    std::ostringstream out;
+    out << "allocations " << stats.allocations
+        << ", frees " << stats.frees
+        << ", allocated " << formatBytes(stats.allocatedBytes)
+        << ", peak " << formatBytes(stats.peakBytes);
+    return out.str();
+}
+
+std::string MemoryStats::formatBytes(size_t bytes)
+{
+    static const char *units[] = {"B", "KiB", "MiB", "GiB"};
+    double value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while ((value >= 1024.0) && (unit + 1 < (sizeof(units) / sizeof(units[0])))) {
+        value /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream out;
+    out.precision(unit == 0 ? 0 : 1);
+    out << std::fixed << value << ' ' << units[unit];
+    return out.str();
+}
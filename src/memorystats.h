@@ -0,0 +1,61 @@
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include "parseresult.h"
+
+#include <cstddef>
+#include <string>
+
+//Allocation counters of a parse run, process wide,
+//collected only when built with PARSER_MEMORY_STATS (glibc only)
+struct AllocationStats {
+    size_t allocations = 0;
+    size_t frees = 0;
+    size_t allocatedBytes = 0;
+    //above level at the start of measurement
+    size_t peakBytes = 0;
+};
+
+//Bytes held by tables of ParseResult
+struct TableMemory {
+    size_t rows = 0;
+    size_t cells = 0;
+    size_t payload = 0;
+    size_t overhead = 0;
+
+    size_t total() const {
+        return rows + cells + payload + overhead;
+    }
+    TableMemory &operator+=(const TableMemory &other) {
+        rows += other.rows;
+        cells += other.cells;
+        payload += other.payload;
+        overhead += other.overhead;
+        return *this;
+    }
+};
+
+class MemoryStats
+{
+public:
+    //Measures allocations made during its lifetime,
+    //scopes must not overlap, each one resets process wide peak
+    class Scope
+    {
+    public:
+        Scope();
+        AllocationStats stats() const;
+
+    private:
+        AllocationStats begin;
+        size_t beginBytes = 0;
+    };
+    //Api
+    static bool isEnabled();
+    static TableMemory tableMemory(const ParseResult &result);
+    static std::string format(const TableMemory &memory);
+    static std::string format(const AllocationStats &stats);
+    static std::string formatBytes(size_t bytes);
+};
+
+#endif // MEMORYSTATS_H
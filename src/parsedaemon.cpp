@@ -0,0 +1,631 @@
+#include "parsedaemon.h"
+
+#include "hwparser.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+ParseDaemon::ParseDaemon(const std::string &socketPath_, unsigned threadsCount_):
+    socketPath(socketPath_),
+    threadsCount(std::max(1u, threadsCount_)) {}
+
+ParseDaemon::~ParseDaemon()
+{
+    stop();
+    for (int fd : {epollFd, wakeFd}) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        //path may belong to someone else by now
+        struct stat info {};
+        if ((socketInode != 0) && (::lstat(socketPath.c_str(), &info) == 0)
+                && (info.st_dev == socketDevice) && (info.st_ino == socketInode)) {
+            ::unlink(socketPath.c_str());
+        }
+    }
+}
+
+bool ParseDaemon::listen()
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        error = "Socket path is too long: " + socketPath;
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((listenFd < 0) || (epollFd < 0) || (wakeFd < 0)) {
+        error = std::string("Can't create socket: ") + std::strerror(errno);
+        return false;
+    }
+    if (!removeStaleSocket(address)) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    if ((::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+            || (::listen(listenFd, SOMAXCONN) != 0)) {
+        error = "Can't listen on " + socketPath + ": " + std::strerror(errno);
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    struct stat info {};
+    if (::lstat(socketPath.c_str(), &info) == 0) {
+        socketDevice = info.st_dev;
+        socketInode = info.st_ino;
+    }
+    for (int fd : {listenFd, wakeFd}) {
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+    return true;
+}
+
+bool ParseDaemon::removeStaleSocket(const sockaddr_un &address)
+{
+    struct stat info {};
+    if (::lstat(socketPath.c_str(), &info) != 0) {
+        return true;
+    }
+    if (!S_ISSOCK(info.st_mode)) {
+        error = socketPath + " exists and is not a socket";
+        return false;
+    }
+    //socket left by crashed daemon refuses connections
+    const int probeFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const bool isLive = (probeFd >= 0)
+            && (::connect(probeFd, reinterpret_cast<const sockaddr *>(&address),
+                          sizeof(address)) == 0);
+    if (probeFd >= 0) {
+        ::close(probeFd);
+    }
+    if (isLive) {
+        error = "Another daemon already listens on " + socketPath;
+        return false;
+    }
+    ::unlink(socketPath.c_str());
+    return true;
+}
+
+void ParseDaemon::run()
+{
+    running = true;
+    for (unsigned i = 0; i < threadsCount; ++i) {
+        workers.emplace_back(&ParseDaemon::work, this);
+    }
+    epoll_event events[maxEvents];
+    while (running) {
+        const int count = ::epoll_wait(epollFd, events, maxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;//loop
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptClients();
+            } else if (fd == wakeFd) {
+                uint64_t value = 0;
+                while (::read(wakeFd, &value, sizeof(value)) > 0) {
+                }
+                finishResponses();
+            } else if (connections.count(fd) == 0) {
+                //closed earlier in this batch
+            } else if (connections[fd].isBusy) {
+                writeClient(fd);
+            } else {
+                readClient(fd);
+            }
+        }
+    }
+    running = false;
+    queueCondition.notify_all();
+    //workers never touch sockets, they only finish current parse
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    for (auto &request : requests) {
+        if (request.passedFd >= 0) {
+            ::close(request.passedFd);
+        }
+    }
+    requests.clear();
+    finished.clear();
+    while (!connections.empty()) {
+        closeClient(connections.begin()->first);
+    }
+}
+
+void ParseDaemon::stop()
+{
+    running = false;
+    if (wakeFd >= 0) {
+        const uint64_t value = 1;
+        //wakes epoll_wait() up
+        [[maybe_unused]] ssize_t written = ::write(wakeFd, &value, sizeof(value));
+    }
+    queueCondition.notify_all();
+}
+
+const std::string &ParseDaemon::errorString() const
+{
+    return error;
+}
+
+void ParseDaemon::work()
+{
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() {
+                return (!running) || (!requests.empty());
+            });
+            if (!running) {
+                return;
+            }
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+        Response response = serveRequest(request);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            finished.push_back(std::move(response));
+        }
+        const uint64_t value = 1;
+        [[maybe_unused]] ssize_t written = ::write(wakeFd, &value, sizeof(value));
+    }
+}
+
+ParseDaemon::Response ParseDaemon::serveRequest(Request &request)
+{
+    using namespace daemon_protocol;
+    Response response;
+    response.clientFd = request.clientFd;
+    Status status = BadRequest;
+    const int passedFd = request.passedFd;
+    try {
+        status = parseRequest(request, response.body);
+    } catch (const std::exception &) {
+        //malformed source must not take worker pool down
+        response.body = nullptr;
+    }
+    if (passedFd >= 0) {
+        ::close(passedFd);
+    }
+    response.header.kind = status;
+    response.header.size = response.body ? response.body->size() : 0;
+    return response;
+}
+
+daemon_protocol::Status ParseDaemon::parseRequest(const Request &request, ResponsePtr &body)
+{
+    using namespace daemon_protocol;
+    const int passedFd = request.passedFd;
+    if ((request.header.kind == ParsePath) || (request.header.kind == ParseBuffer)) {
+        const std::string &payload = request.payload;
+        body = request.header.kind == ParsePath
+                ? parsePath(payload)
+                : parseBuffer(payload.data(), payload.data() + payload.size());
+        return body ? Ok : IoError;
+    }
+    if ((request.header.kind != ParseMemfd) || (!isSealed(passedFd))) {
+        return BadRequest;
+    }
+    //source is mapped, not copied
+    struct stat info {};
+    if ((::fstat(passedFd, &info) == 0) && (info.st_size == 0)) {
+        body = parseBuffer(nullptr, nullptr);
+    } else if (info.st_size > 0) {
+        const size_t size = static_cast<size_t>(info.st_size);
+        void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, passedFd, 0);
+        if (data != MAP_FAILED) {
+            const char *first = static_cast<const char *>(data);
+            try {
+                body = parseBuffer(first, first + size);
+            } catch (...) {
+                ::munmap(data, size);
+                throw;
+            }
+            ::munmap(data, size);
+        }
+    }
+    return body ? Ok : IoError;
+}
+
+void ParseDaemon::acceptClients()
+{
+    while (true) {
+        const int clientFd = ::accept4(listenFd, nullptr, nullptr,
+                                       SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            if ((errno == EINTR) || (errno == ECONNABORTED)) {
+                continue;
+            }
+            return;
+        }
+        connections[clientFd] = Connection();
+        watch(clientFd, EPOLLIN);
+    }
+}
+
+void ParseDaemon::readClient(int clientFd)
+{
+    Connection &connection = connections[clientFd];
+    //reading stops at first complete request, rest waits in socket
+    while ((!connection.isBusy) && (!connection.isPeerClosed)) {
+        const size_t size = connection.input.size();
+        connection.input.resize(size + readChunkSize);
+        iovec data {&connection.input[size], readChunkSize};
+        msghdr message {};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * maxPassedFds)] = {};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        const ssize_t count = ::recvmsg(clientFd, &message, MSG_CMSG_CLOEXEC);
+        connection.input.resize(size + static_cast<size_t>(std::max<ssize_t>(count, 0)));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                closeClient(clientFd);
+            }
+            return;
+        }
+        for (cmsghdr *controlHeader = CMSG_FIRSTHDR(&message); controlHeader != nullptr;
+             controlHeader = CMSG_NXTHDR(&message, controlHeader)) {
+            if ((controlHeader->cmsg_level != SOL_SOCKET)
+                    || (controlHeader->cmsg_type != SCM_RIGHTS)) {
+                continue;
+            }
+            const size_t fdsCount = (controlHeader->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < fdsCount; ++i) {
+                int fd = -1;
+                std::memcpy(&fd, CMSG_DATA(controlHeader) + i * sizeof(int), sizeof(int));
+                const size_t readBegin = connection.inputOffset + size;
+                connection.passedFds.push_back({readBegin, readBegin + static_cast<size_t>(count), fd});
+            }
+        }
+        connection.isPeerClosed = count == 0;
+        if (!dispatch(clientFd)) {
+            closeClient(clientFd);
+            return;
+        }
+    }
+    if ((!connection.isBusy) && connection.isPeerClosed) {
+        closeClient(clientFd);
+    }
+}
+
+bool ParseDaemon::dispatch(int clientFd)
+{
+    using namespace daemon_protocol;
+    Connection &connection = connections[clientFd];
+    Request request;
+    if (connection.input.size() < sizeof(request.header)) {
+        return true;
+    }
+    std::memcpy(&request.header, connection.input.data(), sizeof(request.header));
+    if (request.header.magic != magic) {
+        //framing is lost, connection can't be answered any more
+        return false;
+    }
+    if (request.header.size > maxPayload) {
+        //payload isn't buffered, best effort answer before closing
+        Header response;
+        response.kind = BadRequest;
+        [[maybe_unused]] ssize_t written = ::send(clientFd, &response, sizeof(response),
+                                                  MSG_NOSIGNAL | MSG_DONTWAIT);
+        return false;
+    }
+    const size_t payloadSize = request.header.kind == ParseMemfd
+            ? 0 : static_cast<size_t>(request.header.size);
+    const size_t frameSize = sizeof(request.header) + payloadSize;
+    if (connection.input.size() < frameSize) {
+        return true;
+    }
+    request.clientFd = clientFd;
+    request.payload.assign(connection.input, sizeof(request.header), payloadSize);
+    //kernel may merge earlier requests into the read that carried
+    //descriptor, it belongs to first memfd request starting in that read
+    auto &passedFds = connection.passedFds;
+    const size_t frameBegin = connection.inputOffset;
+    if ((request.header.kind == ParseMemfd) && (!passedFds.empty())
+            && (passedFds.front().readBegin <= frameBegin)
+            && (frameBegin < passedFds.front().readEnd)) {
+        request.passedFd = passedFds.front().fd;
+        passedFds.pop_front();
+    }
+    //no later request starts in reads consumed already
+    while ((!passedFds.empty()) && (passedFds.front().readEnd <= frameBegin + frameSize)) {
+        ::close(passedFds.front().fd);
+        passedFds.pop_front();
+    }
+    connection.input.erase(0, frameSize);
+    connection.inputOffset += frameSize;
+    connection.isBusy = true;
+    //not watched until response is ready, hangup would spin epoll loop
+    watch(clientFd, 0);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        requests.push_back(std::move(request));
+    }
+    queueCondition.notify_one();
+    return true;
+}
+
+void ParseDaemon::finishResponses()
+{
+    std::vector<Response> ready;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        ready.swap(finished);
+    }
+    for (auto &response : ready) {
+        //busy connections are never closed, so descriptor wasn't reused
+        Connection &connection = connections[response.clientFd];
+        connection.output = std::move(response);
+        connection.written = 0;
+        writeClient(connection.output.clientFd);
+    }
+}
+
+void ParseDaemon::writeClient(int clientFd)
+{
+    Connection &connection = connections[clientFd];
+    Response &output = connection.output;
+    if (output.clientFd < 0) {
+        //still parsing
+        return;
+    }
+    const size_t headerSize = sizeof(output.header);
+    const size_t bodySize = output.body ? output.body->size() : 0;
+    while (connection.written < headerSize + bodySize) {
+        const size_t written = connection.written;
+        iovec data[2];
+        size_t partsCount = 0;
+        if (written < headerSize) {
+            data[partsCount++] = {reinterpret_cast<char *>(&output.header) + written,
+                                  headerSize - written};
+        }
+        if (bodySize > 0) {
+            const size_t bodyWritten = written > headerSize ? written - headerSize : 0;
+            data[partsCount++] = {const_cast<char *>(output.body->data()) + bodyWritten,
+                                  bodySize - bodyWritten};
+        }
+        msghdr message {};
+        message.msg_iov = data;
+        message.msg_iovlen = partsCount;
+        const ssize_t count = ::sendmsg(clientFd, &message, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                watch(clientFd, EPOLLOUT);
+            } else {
+                closeClient(clientFd);
+            }
+            return;
+        }
+        connection.written += static_cast<size_t>(count);
+    }
+    connection.output = Response();
+    connection.isBusy = false;
+    //requests pipelined by client may be buffered already
+    if (!dispatch(clientFd)) {
+        closeClient(clientFd);
+    } else if ((!connection.isBusy) && connection.isPeerClosed) {
+        closeClient(clientFd);
+    } else if (!connection.isBusy) {
+        watch(clientFd, EPOLLIN);
+    }
+}
+
+void ParseDaemon::watch(int clientFd, uint32_t events)
+{
+    Connection &connection = connections[clientFd];
+    if (connection.watchedEvents == events) {
+        return;
+    }
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = clientFd;
+    const int operation = connection.watchedEvents == 0 ? EPOLL_CTL_ADD
+                        : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+    ::epoll_ctl(epollFd, operation, clientFd, &event);
+    connection.watchedEvents = events;
+}
+
+void ParseDaemon::closeClient(int clientFd)
+{
+    auto iter = connections.find(clientFd);
+    if (iter == connections.end()) {
+        return;
+    }
+    for (auto &passedFd : iter->second.passedFds) {
+        ::close(passedFd.fd);
+    }
+    connections.erase(iter);
+    //closing removes descriptor from epoll too
+    ::close(clientFd);
+}
+
+bool ParseDaemon::isSealed(int fd)
+{
+    //client shrinking mapped memfd would kill daemon with SIGBUS
+    static const int requiredSeals = F_SEAL_SHRINK | F_SEAL_WRITE;
+    const int seals = fd >= 0 ? ::fcntl(fd, F_GET_SEALS) : -1;
+    return (seals >= 0) && ((seals & requiredSeals) == requiredSeals);
+}
+
+ParseDaemon::ResponsePtr ParseDaemon::parsePath(const std::string &path)
+{
+    struct stat info {};
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if ((fd < 0) || (::fstat(fd, &info) != 0)) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return nullptr;
+    }
+    //unchanged file has same size and modification time
+    const std::string key = "path:" + path + ':' + std::to_string(info.st_size) + ':'
+            + std::to_string(info.st_mtim.tv_sec) + '.' + std::to_string(info.st_mtim.tv_nsec);
+    ResponsePtr response = cached(key);
+    if (!response) {
+        std::string source(static_cast<size_t>(info.st_size), '\0');
+        size_t done = 0;
+        while (done < source.size()) {
+            ssize_t count = ::read(fd, source.data() + done, source.size() - done);
+            if (count <= 0) {
+                break;//loop
+            }
+            done += static_cast<size_t>(count);
+        }
+        ::close(fd);
+        source.resize(done);
+        response = parseSource(source.data(), source.data() + source.size());
+        store(key, response);
+        return response;
+    }
+    ::close(fd);
+    return response;
+}
+
+ParseDaemon::ResponsePtr ParseDaemon::parseBuffer(const char *first, const char *last)
+{
+    //FNV-1a of whole buffer, far cheaper than parsing it
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char *iter = first; iter < last; ++iter) {
+        hash = (hash ^ static_cast<unsigned char>(*iter)) * 0x100000001b3ULL;
+    }
+    const std::string key = "buffer:" + std::to_string(hash) + ':'
+            + std::to_string(last - first);
+    //hash only narrows lookup, equal bytes are required for a hit
+    const std::string_view source(first, static_cast<size_t>(last - first));
+    ResponsePtr response = cached(key, source);
+    if (!response) {
+        response = parseSource(first, last);
+        store(key, response, source);
+    }
+    return response;
+}
+
+ParseDaemon::ResponsePtr ParseDaemon::parseSource(const char *first, const char *last)
+{
+    HWParser::Options options;
+    options.skipPreprocessor = true;
+    HWParser parser(first, last, options);
+    return std::make_shared<const std::string>(toJson(parser.query(HWParser::Query())));
+}
+
+ParseDaemon::ResponsePtr ParseDaemon::cached(const std::string &key, std::string_view source)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto iter = responses.find(key);
+    return (iter != responses.end()) && (iter->second.source == source)
+            ? iter->second.response : nullptr;
+}
+
+void ParseDaemon::store(const std::string &key, const ResponsePtr &response,
+                        std::string_view source)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const size_t bytes = source.size() + response->size();
+    if ((responses.size() >= maxCachedResponses)
+            || (cachedBytes + bytes > maxCachedBytes)) {
+        responses.clear();
+        cachedBytes = 0;
+    }
+    if (bytes > maxCachedBytes) {
+        return;
+    }
+    CacheEntry &entry = responses[key];
+    cachedBytes -= entry.source.size() + (entry.response ? entry.response->size() : 0);
+    entry.source.assign(source);
+    entry.response = response;
+    cachedBytes += bytes;
+}
+
+std::string ParseDaemon::toJson(const std::vector<ParseResult> &results)
+{
+    std::string out = "{\"tables\":[";
+    bool tableComma = false;
+    for (auto &result : results) {
+        if (tableComma) {
+            out += ',';
+        }
+        tableComma = true;
+        out += "{\"identifier\":";
+        appendJsonString(out, result.identifier);
+        out += ",\"ok\":";
+        out += result.ok ? "true" : "false";
+        out += ",\"pointerDepth\":" + std::to_string(result.pointerDepth);
+        out += ",\"declaredRows\":" + std::to_string(result.declaredRows);
+        out += ",\"declaredColumns\":" + std::to_string(result.declaredColumns);
+        out += ",\"output\":";
+        appendJsonString(out, result.output);
+        out += ",\"rows\":[";
+        bool rowComma = false;
+        for (auto &row : result.table) {
+            if (rowComma) {
+                out += ',';
+            }
+            rowComma = true;
+            out += '[';
+            bool cellComma = false;
+            for (auto &cell : row) {
+                if (cellComma) {
+                    out += ',';
+                }
+                cellComma = true;
+                //cells hold Latin1 bytes of source
+                appendJsonString(out, cell.toLatin1().toStdString());
+            }
+            out += ']';
+        }
+        out += "]}";
+    }
+    out += "]}\n";
+    return out;
+}
+
+void ParseDaemon::appendJsonString(std::string &out, const std::string &str)
+{
+    out += '"';
+    for (unsigned char c : str) {
+        if ((c == '"') || (c == '\\')) {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if ((c < 0x20) || (c >= 0x7f)) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
@@ -0,0 +1,131 @@
+#ifndef PARSEDAEMON_H
+#define PARSEDAEMON_H
+
+#include "daemonprotocol.h"
+#include "parseresult.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/un.h>
+
+//Serves parse requests over Unix domain socket (see daemonprotocol.h).
+//One epoll loop reads requests of all connections and hands them to
+//warm worker threads, so idle connections hold no worker.
+//Responses of unchanged files and buffers are cached.
+class ParseDaemon
+{
+public:
+    ParseDaemon(const std::string &socketPath_, unsigned threadsCount_);
+    ParseDaemon(const ParseDaemon &) = delete;
+    ParseDaemon &operator=(const ParseDaemon &) = delete;
+    ~ParseDaemon();
+    //Api
+    bool listen();
+    //serves connections until stop()
+    void run();
+    //safe to call from any thread, run() returns after parses in progress
+    void stop();
+    const std::string &errorString() const;
+
+    static std::string toJson(const std::vector<ParseResult> &results);
+
+protected:
+    //Types
+    using ResponsePtr = std::shared_ptr<const std::string>;
+    struct Request {
+        int clientFd = -1;
+        daemon_protocol::Header header;
+        std::string payload;
+        int passedFd = -1;
+    };
+    struct Response {
+        int clientFd = -1;
+        daemon_protocol::Header header;
+        ResponsePtr body;
+    };
+    struct CacheEntry {
+        //bytes of inline source, its key is only a hash
+        std::string source;
+        ResponsePtr response;
+    };
+    struct PassedFd {
+        //connection offsets of bytes of the read that carried descriptor
+        size_t readBegin = 0;
+        size_t readEnd = 0;
+        int fd = -1;
+    };
+    struct Connection {
+        //received bytes of requests not yet handed to workers
+        std::string input;
+        //bytes of connection dropped from front of input
+        size_t inputOffset = 0;
+        //descriptors not yet claimed by memfd requests
+        std::deque<PassedFd> passedFds;
+        //one request at a time keeps responses in order
+        bool isBusy = false;
+        bool isPeerClosed = false;
+        uint32_t watchedEvents = 0;
+        Response output;
+        size_t written = 0;
+    };
+    //Inner api
+    bool removeStaleSocket(const sockaddr_un &address);
+    void work();
+    Response serveRequest(Request &request);
+    daemon_protocol::Status parseRequest(const Request &request, ResponsePtr &body);
+    void acceptClients();
+    void readClient(int clientFd);
+    bool dispatch(int clientFd);
+    void finishResponses();
+    void writeClient(int clientFd);
+    void watch(int clientFd, uint32_t events);
+    void closeClient(int clientFd);
+    static bool isSealed(int fd);
+    ResponsePtr parsePath(const std::string &path);
+    ResponsePtr parseBuffer(const char *first, const char *last);
+    ResponsePtr parseSource(const char *first, const char *last);
+    //source is empty for files, their key already identifies content
+    ResponsePtr cached(const std::string &key, std::string_view source = {});
+    void store(const std::string &key, const ResponsePtr &response,
+               std::string_view source = {});
+    static void appendJsonString(std::string &out, const std::string &str);
+    //Static data
+    inline static const size_t maxCachedResponses = 4096;
+    inline static const size_t maxCachedBytes = size_t(256) << 20;
+    inline static const size_t readChunkSize = 1 << 16;
+    inline static const size_t maxPassedFds = 4;
+    inline static const int maxEvents = 64;
+    //Data
+    std::string socketPath;
+    unsigned threadsCount;
+    int listenFd = -1;
+    //identity of bound socket file, only it is unlinked on exit
+    dev_t socketDevice = 0;
+    ino_t socketInode = 0;
+    int epollFd = -1;
+    //eventfd waking epoll loop for finished responses and stop()
+    int wakeFd = -1;
+    std::atomic<bool> running {false};
+    std::string error;
+    //owned by epoll loop thread
+    std::unordered_map<int, Connection> connections;
+    std::vector<std::thread> workers;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<Request> requests;
+    std::vector<Response> finished;
+    std::mutex cacheMutex;
+    std::unordered_map<std::string, CacheEntry> responses;
+    size_t cachedBytes = 0;
+};
+
+#endif // PARSEDAEMON_H
@@ -0,0 +1,118 @@
+//Minimal client of ParseDaemon, prints JSON of tables of every file.
+//"-" reads source from stdin and passes it to daemon in memfd.
+
+#include "daemonprotocol.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/un.h>
+
+static int connectTo(const char *socketPath)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(socketPath) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    std::strcpy(address.sun_path, socketPath);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if ((fd >= 0) && (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)) {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static int stdinToMemfd()
+{
+    int fd = ::memfd_create("parser-client-stdin", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return -1;
+    }
+    char buffer[1 << 16];
+    ssize_t count;
+    while ((count = ::read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+        if (::write(fd, buffer, static_cast<size_t>(count)) != count) {
+            ::close(fd);
+            return -1;
+        }
+    }
+    //daemon maps memfd only if it can't change under the mapping
+    if (::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool request(int socketFd, const char *arg)
+{
+    using namespace daemon_protocol;
+    Header header;
+    int passedFd = -1;
+    const bool isStdin = std::strcmp(arg, "-") == 0;
+    std::string path;
+    if (isStdin) {
+        passedFd = stdinToMemfd();
+        if (passedFd < 0) {
+            std::fprintf(stderr, "Can't buffer stdin: %s\n", std::strerror(errno));
+            return false;
+        }
+        header.kind = ParseMemfd;
+    } else {
+        //daemon has its own working directory
+        char *absolute = ::realpath(arg, nullptr);
+        path = absolute ? absolute : arg;
+        std::free(absolute);
+        header.kind = ParsePath;
+        header.size = path.size();
+    }
+    bool sent = sendHeader(socketFd, header, passedFd)
+            && writeAll(socketFd, path.data(), path.size());
+    if (passedFd >= 0) {
+        ::close(passedFd);
+    }
+    Header response;
+    int unused = -1;
+    if ((!sent) || (!receiveHeader(socketFd, response, unused))) {
+        std::fprintf(stderr, "Daemon closed connection\n");
+        return false;
+    }
+    std::string json(response.size, '\0');
+    if (!readAll(socketFd, json.data(), json.size())) {
+        std::fprintf(stderr, "Daemon closed connection\n");
+        return false;
+    }
+    if (response.kind != Ok) {
+        std::fprintf(stderr, "%s: %s\n", arg,
+                     response.kind == IoError ? "can't read source" : "bad request");
+        return false;
+    }
+    std::fwrite(json.data(), 1, json.size(), stdout);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <socket> <file|-> [file...]\n", argv[0]);
+        return 2;
+    }
+    int socketFd = connectTo(argv[1]);
+    if (socketFd < 0) {
+        std::fprintf(stderr, "Can't connect to %s: %s\n", argv[1], std::strerror(errno));
+        return 2;
+    }
+    bool ok = true;
+    for (int i = 2; i < argc; ++i) {
+        ok = request(socketFd, argv[i]) && ok;
+    }
+    ::close(socketFd);
+    return ok ? 0 : 1;
+}
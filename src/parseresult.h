@@ -3,15 +3,81 @@
 
 #include <QtCore>
 
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
 using StringTable = QVector<QVector<QString>>;
 using StringRow = QVector<QString>;
+//Dictionary ids of cells, laid out like rows of the literal
+using IdTable = QVector<QVector<int>>;
+using IdRow = QVector<int>;
+
+//Fixed-shape row-major storage for fully sized declarations (char* t[N][M]),
+//missing cells are left empty like zero-initialized pointers in C
+struct DenseStringTable {
+    size_t rows = 0;
+    size_t columns = 0;
+    QVector<QString> cells;
+
+    const QString &at(size_t row, size_t column) const {
+        return cells[static_cast<int>(row * columns + column)];
+    }
+};
+
+//Top-level table declaration found by HWParser::index(),
+//indices are byte offsets of whole statement including modifiers and ';'
+struct Declaration {
+    std::string identifier;
+    int pointerDepth = 0;
+    size_t declaredRows = 0;
+    size_t declaredColumns = 0;
+    size_t beginIdx = 0;
+    size_t endIdx = 0;
+};
 
 struct ParseResult {
     StringTable table;
+    DenseStringTable denseTable;
+    //distinct cells and ids of all cells, filled when interning
+    QVector<QString> dictionary;
+    IdTable idTable;
+    //content hashes for change detection, see TableDiff
+    QVector<uint64_t> rowHashes;
+    uint64_t tableHash = 0;
     std::string output;
     bool ok = false;
+    bool isDense = false;
+    std::string identifier;
+    //1 for char*, 2 for char**, 3 for char***
+    int pointerDepth = 0;
+    size_t tableBeginIdx = 0;
+    size_t tableEndIdx = 0;
+    //0 if dimension is omitted or not declared
+    size_t declaredRows = 0;
+    size_t declaredColumns = 0;
+};
+
+//Table of ReusableParser, every container allocates from one memory resource
+using PmrStringRow = std::pmr::vector<std::pmr::string>;
+using PmrStringTable = std::pmr::vector<PmrStringRow>;
+
+struct PmrParseResult {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    explicit PmrParseResult(allocator_type allocator = {}):
+        table(allocator), output(allocator), identifier(allocator) {}
+
+    PmrStringTable table;
+    std::pmr::string output;
+    bool ok = false;
+    std::pmr::string identifier;
+    int pointerDepth = 0;
     size_t tableBeginIdx = 0;
     size_t tableEndIdx = 0;
+    size_t declaredRows = 0;
+    size_t declaredColumns = 0;
 };
 
 #endif // PARSERESULT_H
@@ -0,0 +1,39 @@
+#include "reusableparser.h"
+
+ReusableParser::ReusableParser():
+    HWParser(nullptr, nullptr) {}
+
+void ReusableParser::reset(iter_type first_, iter_type last_)
+{
+    HWParser::reset(first_, last_);
+}
+
+PmrParseResult ReusableParser::parse(std::pmr::memory_resource *resource)
+{
+    PmrParseResult result(resource);
+    //clear without giving capacity back
+    declaration.identifier.clear();
+    declaration.pointerDepth = 0;
+    declaration.declaredRows = 0;
+    declaration.declaredColumns = 0;
+    declaration.tableBeginIdx = 0;
+    declaration.tableEndIdx = 0;
+    out.str({});
+    out.clear();
+    start(declaration, out);
+    //declaration up to '='
+    run(Context::Table);
+    if ((ctx.stage == Context::Table) && ctx.shouldContinue && (current < last)) {
+        result.ok = readTable(result.table);
+    }
+    result.identifier = declaration.identifier;
+    result.pointerDepth = declaration.pointerDepth;
+    result.tableBeginIdx = declaration.tableBeginIdx;
+    result.tableEndIdx = declaration.tableEndIdx;
+    result.declaredRows = declaration.declaredRows;
+    result.declaredColumns = declaration.declaredColumns;
+    if (out.tellp() > 0) {
+        result.output = out.str();
+    }
+    return result;
+}
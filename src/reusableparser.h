@@ -0,0 +1,30 @@
+#ifndef REUSABLEPARSER_H
+#define REUSABLEPARSER_H
+
+#include "hwparser.h"
+
+#include <memory_resource>
+#include <sstream>
+
+//Parser for many small sources, keeps its buffers between parses and
+//allocates results from caller's memory resource, e.g. monotonic buffer
+//released after each batch. Results must be destroyed before resource
+//is released.
+class ReusableParser : protected HWParser
+{
+public:
+    ReusableParser();
+    ReusableParser(const ReusableParser &) = delete;
+    ReusableParser &operator=(const ReusableParser &) = delete;
+    //Api
+    void reset(iter_type first_, iter_type last_);
+    PmrParseResult parse(std::pmr::memory_resource *resource
+                         = std::pmr::get_default_resource());
+
+protected:
+    //Data
+    ParseResult declaration;
+    stringstream out;
+};
+
+#endif // REUSABLEPARSER_H
@@ -0,0 +1,164 @@
+#include "structuralindex.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+bool StructuralIndex::build(iter_type first, iter_type last)
+{
+    const size_t size = static_cast<size_t>(last - first);
+    offsets.clear();
+    uint64_t prevEscaped = 0;
+    uint64_t prevInString = 0;
+    int depth = 0;
+    char tail[blockSize];
+    for (size_t blockIdx = 0; blockIdx < size; blockIdx += blockSize) {
+        const char *block = first + blockIdx;
+        if (size - blockIdx < blockSize) {
+            //last partial block padded with spaces
+            std::memset(tail, ' ', blockSize);
+            std::memcpy(tail, block, size - blockIdx);
+            block = tail;
+        }
+        BlockMasks masks = classify(block);
+        const uint64_t escaped = findEscaped(masks.backslash, prevEscaped);
+        const uint64_t quote = masks.quote & (~escaped);
+        //bits from opening quote up to char before closing one
+        const uint64_t inString = prefixXor(quote) ^ prevInString;
+        prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        const uint64_t structural = masks.structural & (~inString);
+        bool isEnded = false;
+        //hazards after the value don't matter
+        const uint64_t inValue = findValueEnd(structural, block, depth, isEnded);
+        if (masks.hazard & (~inString) & inValue) {
+            offsets.clear();
+            return false;
+        }
+        appendPositions(structural & inValue, blockIdx);
+        if (isEnded) {
+            break;//loop
+        }
+    }
+    return true;
+}
+
+const std::vector<size_t> &StructuralIndex::positions() const
+{
+    return offsets;
+}
+
+StructuralIndex::BlockMasks StructuralIndex::classify(const char *block)
+{
+    BlockMasks masks;
+#ifdef __SSE2__
+    for (size_t i = 0; i < blockSize; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        auto maskOf = [&chunk](char c) {
+            return static_cast<uint64_t>(static_cast<uint32_t>(
+                       _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)))));
+        };
+        masks.quote |= maskOf('"') << i;
+        masks.backslash |= maskOf('\\') << i;
+        masks.structural |= (maskOf('{') | maskOf('}') | maskOf(',') | maskOf(';')) << i;
+        masks.hazard |= (maskOf('/') | maskOf('\'')) << i;
+    }
+#else
+    for (size_t i = 0; i < blockSize; ++i) {
+        const uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+        case '"':
+            masks.quote |= bit;
+            break;//switch
+        case '\\':
+            masks.backslash |= bit;
+            break;//switch
+        case '{':
+        case '}':
+        case ',':
+        case ';':
+            masks.structural |= bit;
+            break;//switch
+        case '/':
+        case '\'':
+            masks.hazard |= bit;
+            break;//switch
+        default:
+            break;//switch
+        }
+    }
+#endif
+    return masks;
+}
+
+uint64_t StructuralIndex::findEscaped(uint64_t backslash, uint64_t &prevEscaped)
+{
+    //char is escaped if it follows odd sequence of backslashes
+    static const uint64_t evenBits = 0x5555555555555555ULL;
+    backslash &= ~prevEscaped;
+    const uint64_t followsEscape = (backslash << 1) | prevEscaped;
+    const uint64_t oddSequenceStarts = backslash & (~evenBits) & (~followsEscape);
+    const uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    //carry out of the block means last char escapes first of next block
+    prevEscaped = sequencesStartingOnEvenBits < backslash ? 1 : 0;
+    const uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+}
+
+uint64_t StructuralIndex::prefixXor(uint64_t mask)
+{
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+
+uint64_t StructuralIndex::findValueEnd(uint64_t structural, const char *block,
+                                       int &depth, bool &isEnded)
+{
+    for (uint64_t mask = structural; mask != 0; mask &= mask - 1) {
+        const uint64_t bit = mask & (~mask + 1);
+        switch (block[lowestBitIdx(bit)]) {
+        case '{':
+            ++depth;
+            break;//switch
+        case '}':
+            --depth;
+            isEnded = depth <= 0;
+            break;//switch
+        default:
+            isEnded = depth <= 0;
+            break;//switch
+        }
+        if (isEnded) {
+            //bits up to and including the closing structural
+            return bit | (bit - 1);
+        }
+    }
+    return ~uint64_t(0);
+}
+
+size_t StructuralIndex::lowestBitIdx(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_ctzll(mask));
+#else
+    size_t bit = 0;
+    while (((mask >> bit) & 1) == 0) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+void StructuralIndex::appendPositions(uint64_t mask, size_t blockIdx)
+{
+    while (mask != 0) {
+        offsets.push_back(blockIdx + lowestBitIdx(mask));
+        mask &= mask - 1;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef STRUCTURALINDEX_H
+#define STRUCTURALINDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//First stage of parallel table parsing, finds '{', '}', ',' and ';'
+//outside of string literals in 64 byte blocks (SSE2 when available)
+//with escaped quotes handled like in simdjson
+class StructuralIndex
+{
+public:
+    using iter_type = const char*;
+    //Api
+    //indexes value starting at first up to '}', ',' or ';' closing it
+    //at depth 0, bytes after it are never read;
+    //false if value has comments or char literals outside of strings,
+    //they can hide structural characters and need sequential parsing
+    bool build(iter_type first, iter_type last);
+    //offsets from first, in increasing order
+    const std::vector<size_t> &positions() const;
+
+protected:
+    //Types
+    struct BlockMasks {
+        uint64_t quote = 0;
+        uint64_t backslash = 0;
+        uint64_t structural = 0;
+        uint64_t hazard = 0;
+    };
+    //Inner api
+    static inline BlockMasks classify(const char *block);
+    static inline uint64_t findEscaped(uint64_t backslash, uint64_t &prevEscaped);
+    static inline uint64_t prefixXor(uint64_t mask);
+    static inline uint64_t findValueEnd(uint64_t structural, const char *block,
+                                        int &depth, bool &isEnded);
+    static inline size_t lowestBitIdx(uint64_t mask);
+    inline void appendPositions(uint64_t mask, size_t blockIdx);
+    //Static data
+    inline static const size_t blockSize = 64;
+    //Data
+    std::vector<size_t> offsets;
+};
+
+#endif // STRUCTURALINDEX_H
@@ -0,0 +1,136 @@
+#include "tablediff.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+TableDiff TableDiff::between(const ParseResult &before, const ParseResult &after)
+{
+    TableDiff diff;
+    const QVector<uint64_t> &oldHashes = before.rowHashes;
+    const QVector<uint64_t> &newHashes = after.rowHashes;
+    const size_t oldSize = static_cast<size_t>(oldHashes.size());
+    const size_t newSize = static_cast<size_t>(newHashes.size());
+    if ((before.tableHash == after.tableHash) && (oldSize == newSize)) {
+        return diff;
+    }
+    //patience diff, ranges are popped in table order so indices
+    //in added, removed and changed stay ascending
+    std::vector<Range> ranges {{0, oldSize, 0, newSize}};
+    while (!ranges.empty()) {
+        const Range range = ranges.back();
+        ranges.pop_back();
+        diff.diffRange(oldHashes, newHashes, range, ranges);
+    }
+    return diff;
+}
+
+void TableDiff::diffRange(const QVector<uint64_t> &oldHashes, const QVector<uint64_t> &newHashes,
+                          Range range, std::vector<Range> &ranges)
+{
+    auto oldAt = [&oldHashes](size_t idx) {
+        return oldHashes[static_cast<int>(idx)];
+    };
+    auto newAt = [&newHashes](size_t idx) {
+        return newHashes[static_cast<int>(idx)];
+    };
+    //equal rows at both ends match without search
+    while ((range.oldBegin < range.oldEnd) && (range.newBegin < range.newEnd)
+           && (oldAt(range.oldBegin) == newAt(range.newBegin))) {
+        ++range.oldBegin;
+        ++range.newBegin;
+    }
+    while ((range.oldBegin < range.oldEnd) && (range.newBegin < range.newEnd)
+           && (oldAt(range.oldEnd - 1) == newAt(range.newEnd - 1))) {
+        --range.oldEnd;
+        --range.newEnd;
+    }
+    if ((range.oldBegin == range.oldEnd) || (range.newBegin == range.newEnd)) {
+        addGap(range.oldBegin, range.oldEnd, range.newBegin, range.newEnd);
+        return;
+    }
+    //only rows unique on both sides can be anchors, duplicates
+    //would let one early match pull everything else out of order
+    struct Occurrence {
+        size_t oldCount = 0;
+        size_t newCount = 0;
+        size_t oldIdx = 0;
+    };
+    std::unordered_map<uint64_t, Occurrence> occurrences;
+    occurrences.reserve(range.oldEnd - range.oldBegin);
+    for (size_t i = range.oldBegin; i < range.oldEnd; ++i) {
+        Occurrence &occurrence = occurrences[oldAt(i)];
+        ++occurrence.oldCount;
+        occurrence.oldIdx = i;
+    }
+    for (size_t i = range.newBegin; i < range.newEnd; ++i) {
+        auto iter = occurrences.find(newAt(i));
+        if (iter != occurrences.end()) {
+            ++iter->second.newCount;
+        }
+    }
+    IndexPairs unique;
+    for (size_t i = range.newBegin; i < range.newEnd; ++i) {
+        auto iter = occurrences.find(newAt(i));
+        if ((iter != occurrences.end())
+                && (iter->second.oldCount == 1) && (iter->second.newCount == 1)) {
+            unique.emplace_back(iter->second.oldIdx, i);
+        }
+    }
+    const IndexPairs anchors = longestIncreasing(unique);
+    if (anchors.empty()) {
+        //rows between anchors are paired as changed, the rest is added or removed
+        addGap(range.oldBegin, range.oldEnd, range.newBegin, range.newEnd);
+        return;
+    }
+    //gaps between anchors are diffed again, last one is pushed first
+    size_t oldEnd = range.oldEnd;
+    size_t newEnd = range.newEnd;
+    for (auto iter = anchors.rbegin(); iter != anchors.rend(); ++iter) {
+        ranges.push_back({iter->first + 1, oldEnd, iter->second + 1, newEnd});
+        oldEnd = iter->first;
+        newEnd = iter->second;
+    }
+    ranges.push_back({range.oldBegin, oldEnd, range.newBegin, newEnd});
+}
+
+void TableDiff::addGap(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd)
+{
+    while ((oldBegin < oldEnd) && (newBegin < newEnd)) {
+        changed.emplace_back(oldBegin++, newBegin++);
+    }
+    while (oldBegin < oldEnd) {
+        removed.push_back(oldBegin++);
+    }
+    while (newBegin < newEnd) {
+        added.push_back(newBegin++);
+    }
+}
+
+TableDiff::IndexPairs TableDiff::longestIncreasing(const IndexPairs &pairs)
+{
+    //patience sorting by older index, pairs come ordered by newer one
+    static const size_t none = std::numeric_limits<size_t>::max();
+    std::vector<size_t> pileTops;
+    std::vector<size_t> previous(pairs.size(), none);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        auto pile = std::lower_bound(pileTops.begin(), pileTops.end(), pairs[i].first,
+                                     [&pairs](size_t top, size_t oldIdx) {
+            return pairs[top].first < oldIdx;
+        });
+        if (pile != pileTops.begin()) {
+            previous[i] = *(pile - 1);
+        }
+        if (pile == pileTops.end()) {
+            pileTops.push_back(i);
+        } else {
+            (*pile) = i;
+        }
+    }
+    IndexPairs sequence;
+    for (size_t i = pileTops.empty() ? none : pileTops.back(); i != none; i = previous[i]) {
+        sequence.push_back(pairs[i]);
+    }
+    std::reverse(sequence.begin(), sequence.end());
+    return sequence;
+}
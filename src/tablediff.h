@@ -0,0 +1,42 @@
+#ifndef TABLEDIFF_H
+#define TABLEDIFF_H
+
+#include "parseresult.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//Row changes between two results of the same table, computed from
+//ParseResult::rowHashes only, cells are never compared
+struct TableDiff {
+    //indices in the newer table
+    std::vector<size_t> added;
+    //indices in the older table
+    std::vector<size_t> removed;
+    //pairs of older and newer index
+    std::vector<std::pair<size_t, size_t>> changed;
+
+    bool isEmpty() const {
+        return added.empty() && removed.empty() && changed.empty();
+    }
+
+    static TableDiff between(const ParseResult &before, const ParseResult &after);
+
+protected:
+    //Types
+    struct Range {
+        size_t oldBegin = 0;
+        size_t oldEnd = 0;
+        size_t newBegin = 0;
+        size_t newEnd = 0;
+    };
+    using IndexPairs = std::vector<std::pair<size_t, size_t>>;
+    //Inner api
+    void diffRange(const QVector<uint64_t> &oldHashes, const QVector<uint64_t> &newHashes,
+                   Range range, std::vector<Range> &ranges);
+    void addGap(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd);
+    static IndexPairs longestIncreasing(const IndexPairs &pairs);
+};
+
+#endif // TABLEDIFF_H
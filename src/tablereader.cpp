@@ -0,0 +1,70 @@
+#include "tablereader.h"
+
+TableReader::TableReader(iter_type first_, iter_type last_):
+    HWParser(first_, last_)
+{
+    start(res, out);
+}
+
+bool TableReader::nextRow(StringRow &row)
+{
+    if (!prepareRow()) {
+        return false;
+    }
+    if (!readRow(row)) {
+        state = Finished;
+        return false;
+    }
+    return true;
+}
+
+bool TableReader::nextRawRow(QVector<string_view> &row)
+{
+    if (!prepareRow()) {
+        return false;
+    }
+    if (!readRawRow(row)) {
+        state = Finished;
+        return false;
+    }
+    return true;
+}
+
+bool TableReader::atEnd() const
+{
+    return state == Finished;
+}
+
+const ParseResult &TableReader::result()
+{
+    res.output = out.str();
+    return res;
+}
+
+bool TableReader::prepareRow()
+{
+    if (state == NotStarted) {
+        state = Finished;
+        //declaration up to '='
+        run(Context::Table);
+        if ((ctx.stage != Context::Table) || (!ctx.shouldContinue)
+                || (current >= last) || (!readTableBegin())) {
+            return false;
+        }
+        state = Rows;
+    }
+    if (state != Rows) {
+        return false;
+    }
+    if (current >= last) {
+        state = Finished;
+        return false;
+    }
+    if ((*current) == '{') {
+        return true;
+    }
+    //after all rows
+    state = Finished;
+    res.ok = readTableEnd();
+    return false;
+}
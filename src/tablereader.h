@@ -0,0 +1,37 @@
+#ifndef TABLEREADER_H
+#define TABLEREADER_H
+
+#include "hwparser.h"
+
+#include <sstream>
+
+//Pull-based reader, advances through source only as far as next row,
+//so rows can be consumed before the whole table is read.
+//Source must outlive reader, raw rows point into it.
+class TableReader : protected HWParser
+{
+public:
+    TableReader(iter_type first_, iter_type last_);
+    TableReader(const TableReader &) = delete;
+    TableReader &operator=(const TableReader &) = delete;
+    //Api
+    //row is cleared and refilled, reuse it between calls to keep memory constant
+    bool nextRow(StringRow &row);
+    //cells as they are in source, without quotes and with escapes not decoded
+    bool nextRawRow(QVector<string_view> &row);
+    bool atEnd() const;
+    //everything except table, ok becomes true after last row was read
+    const ParseResult &result();
+
+protected:
+    //Inner api
+    bool prepareRow();
+    //Types
+    enum State { NotStarted, Rows, Finished };
+    //Data
+    ParseResult res;
+    stringstream out;
+    State state = NotStarted;
+};
+
+#endif // TABLEREADER_H
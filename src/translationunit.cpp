@@ -0,0 +1,140 @@
+#include "translationunit.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unordered_set>
+
+SourceCache::SourcePtr SourceCache::source(const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iter = sources.find(path);
+        if (iter != sources.end()) {
+            return iter->second;
+        }
+    }
+    //read outside of lock, other files may be loaded meanwhile
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+    auto text = std::make_shared<const std::string>(
+                std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>());
+    std::lock_guard<std::mutex> lock(mutex);
+    return sources.emplace(path, std::move(text)).first->second;
+}
+
+SourceCache::ResultPtr SourceCache::result(const std::string &path) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = results.find(path);
+    return iter != results.end() ? iter->second : nullptr;
+}
+
+void SourceCache::store(const ResultPtr &result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    results[result->path] = result;
+}
+
+void SourceCache::invalidate(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sources.erase(path);
+    results.erase(path);
+}
+
+void SourceCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sources.clear();
+    results.clear();
+}
+
+TranslationUnitParser::TranslationUnitParser(SourceCache &cache_,
+                                             HWParser::Options options_):
+    cache(cache_), options(options_)
+{
+    options.skipPreprocessor = true;
+    options.followIncludes = true;
+}
+
+std::vector<SourceCache::ResultPtr> TranslationUnitParser::parse(const std::string &rootPath)
+{
+    std::vector<SourceCache::ResultPtr> results;
+    std::vector<std::string> wave {canonicalPath(rootPath)};
+    std::unordered_set<std::string> visited(wave.begin(), wave.end());
+    const size_t maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+    while (!wave.empty()) {
+        std::vector<SourceCache::ResultPtr> waveResults(wave.size());
+        std::atomic<size_t> next {0};
+        auto work = [&]() {
+            for (size_t i = next++; i < wave.size(); i = next++) {
+                waveResults[i] = parseFile(wave[i]);
+            }
+        };
+        std::vector<std::thread> workers;
+        //calling thread is a worker too
+        for (size_t i = 1; i < std::min(maxWorkers, wave.size()); ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        std::vector<std::string> nextWave;
+        for (auto &result : waveResults) {
+            for (auto &include : result->includes) {
+                if (visited.insert(include).second) {
+                    nextWave.push_back(include);
+                }
+            }
+            results.push_back(std::move(result));
+        }
+        wave = std::move(nextWave);
+    }
+    return results;
+}
+
+SourceCache::ResultPtr TranslationUnitParser::parseFile(const std::string &path)
+{
+    if (auto cached = cache.result(path)) {
+        return cached;
+    }
+    auto result = std::make_shared<FileParseResult>();
+    result->path = path;
+    SourceCache::SourcePtr source = cache.source(path);
+    if (source) {
+        result->loaded = true;
+        const char *first = source->data();
+        const char *last = first + source->size();
+        HWParser indexer(first, last, options);
+        //single skim finds tables and includes, then only tables are parsed
+        for (auto &declaration : indexer.index()) {
+            HWParser parser(first + declaration.beginIdx,
+                            first + declaration.endIdx, options);
+            ParseResult table = parser.parse();
+            table.tableBeginIdx += declaration.beginIdx;
+            table.tableEndIdx += declaration.beginIdx;
+            result->tables.push_back(std::move(table));
+        }
+        const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        for (auto &include : indexer.includedFiles()) {
+            result->includes.push_back(canonicalPath((directory / include).string()));
+        }
+    }
+    cache.store(result);
+    return result;
+}
+
+std::string TranslationUnitParser::canonicalPath(const std::string &path)
+{
+    std::error_code error;
+    auto canonical = std::filesystem::weakly_canonical(path, error);
+    return error ? path : canonical.string();
+}
@@ -0,0 +1,60 @@
+#ifndef TRANSLATIONUNIT_H
+#define TRANSLATIONUNIT_H
+
+#include "hwparser.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//All tables of one file, paths are canonical
+struct FileParseResult {
+    std::string path;
+    bool loaded = false;
+    std::vector<ParseResult> tables;
+    std::vector<std::string> includes;
+};
+
+//Thread safe cache of file contents and their parse results,
+//shared between parsers so every file is read and parsed once
+class SourceCache
+{
+public:
+    using SourcePtr = std::shared_ptr<const std::string>;
+    using ResultPtr = std::shared_ptr<const FileParseResult>;
+    //Api
+    SourcePtr source(const std::string &path);
+    ResultPtr result(const std::string &path) const;
+    void store(const ResultPtr &result);
+    void invalidate(const std::string &path);
+    void clear();
+
+protected:
+    //Data
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, SourcePtr> sources;
+    std::unordered_map<std::string, ResultPtr> results;
+};
+
+//Parses file with its local includes, files of the same include depth
+//are loaded and parsed concurrently
+class TranslationUnitParser
+{
+public:
+    TranslationUnitParser(SourceCache &cache_, HWParser::Options options_);
+    //Api
+    //root first, then includes in breadth-first order, each file once
+    std::vector<SourceCache::ResultPtr> parse(const std::string &rootPath);
+    SourceCache::ResultPtr parseFile(const std::string &path);
+
+    static std::string canonicalPath(const std::string &path);
+
+protected:
+    //Data
+    SourceCache &cache;
+    HWParser::Options options;
+};
+
+#endif // TRANSLATIONUNIT_H